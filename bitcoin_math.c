@@ -20,13 +20,51 @@
  */
 
 #include <ctype.h>
-#include <math.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_ATOMICS__)
+#include <stdatomic.h>
+#define HASH_ATOMIC _Atomic // backend and lane kernel pointers of the sha256 and sha512 sections
+#define HASH_LOAD_ACQUIRE(p) atomic_load_explicit(p, memory_order_acquire)
+#define HASH_STORE_RELEASE(p, v) atomic_store_explicit(p, v, memory_order_release)
+#define HASH_CAS(p, e, d) atomic_compare_exchange_strong(p, e, d)
+#else
+#define HASH_ATOMIC volatile // single threaded builds only
+#define HASH_LOAD_ACQUIRE(p) (*(p))
+#define HASH_STORE_RELEASE(p, v) (*(p) = (v))
+#define HASH_CAS(p, e, d) (*(p) == *(e) ? (*(p) = (d), 1) : (*(e) = *(p), 0))
+#endif
+
+#if !defined(SHA256_NO_HW) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SHA256_SHANI 1 // x86 sha extensions, used when cpuid reports them
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+// the sha512 intrinsics need gcc 14 or clang 18, older compilers leave SHA512_NI unset and sha512 portable
+// sha512_blocks_ni was built and checked only through an emulation of the instructions, it has not run on sha512 capable hardware yet
+#if !defined(SHA512_NO_HW) && (defined(__x86_64__) || defined(__i386__)) && ((defined(__clang__) && __clang_major__ >= 18) || (!defined(__clang__) && defined(__GNUC__) && __GNUC__ >= 14))
+#define SHA512_NI 1 // x86 sha512 extensions, used when cpuid reports them
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+#if !defined(SHA256_NO_HW) && defined(__GNUC__)
+#define SHA256_LANES 16 // messages hashed side by side by sha256_many through gcc vector extensions, split over 4, 8 or 16 wide registers by the target
+#endif
+
+#if !defined(SHA256_NO_HW) && defined(__GNUC__) && defined(__aarch64__) && (defined(__linux__) || defined(__APPLE__))
+#define SHA256_ARMV8 1 // armv8 sha2 instructions, used when hwcap reports them
+#include <arm_neon.h>
+#if defined(__linux__)
+#include <sys/auxv.h>
+#endif
+#endif
+
 /* MISCELLANEOUS */
 
 const char bip39_wds[2048][9] = {"abandon", "ability", "able", "about", "above", "absent", "absorb", "abstract", "absurd", "abuse", "access", "accident", "account", "accuse", "achieve", "acid", "acoustic", "acquire", "across", "act", "action", "actor", "actress", "actual", "adapt", "add", "addict", "address", "adjust", "admit", "adult", "advance", "advice", "aerobic", "affair", "afford", "afraid", "again", "age", "agent", "agree", "ahead", "aim", "air", "airport", "aisle", "alarm", "album", "alcohol", "alert", "alien", "all", "alley", "allow", "almost", "alone", "alpha", "already", "also", "alter", "always", "amateur", "amazing", "among", "amount", "amused", "analyst", "anchor", "ancient", "anger", "angle", "angry", "animal", "ankle", "announce", "annual", "another", "answer", "antenna", "antique", "anxiety", "any", "apart", "apology", "appear", "apple", "approve", "april", "arch", "arctic", "area", "arena", "argue", "arm", "armed", "armor", "army", "around", "arrange", "arrest", "arrive", "arrow", "art", "artefact", "artist", "artwork", "ask", "aspect", "assault", "asset", "assist", "assume", "asthma", "athlete", "atom", "attack", "attend", "attitude", "attract", "auction", "audit", "august", "aunt", "author", "auto", "autumn", "average", "avocado", "avoid", "awake", "aware", "away", "awesome", "awful", "awkward", "axis", "baby", "bachelor", "bacon", "badge", "bag", "balance", "balcony", "ball", "bamboo", "banana", "banner", "bar", "barely", "bargain", "barrel", "base", "basic", "basket", "battle", "beach", "bean", "beauty", "because", "become", "beef", "before", "begin", "behave", "behind", "believe", "below", "belt", "bench", "benefit", "best", "betray", "better", "between", "beyond", "bicycle", "bid", "bike", "bind", "biology", "bird", "birth", "bitter", "black", "blade", "blame", "blanket", "blast", "bleak", "bless", "blind", "blood", "blossom", "blouse", "blue", "blur", "blush", "board", "boat", "body", "boil", "bomb", "bone", "bonus", "book", "boost", "border", "boring", "borrow", "boss", "bottom", "bounce", "box", "boy", "bracket", "brain", "brand", "brass", "brave", "bread", "breeze", "brick", "bridge", "brief", "bright", "bring", "brisk", "broccoli", "broken", "bronze", "broom", "brother", "brown", "brush", "bubble", "buddy", "budget", "buffalo", "build", "bulb", "bulk", "bullet", "bundle", "bunker", "burden", "burger", "burst", "bus", "business", "busy", "butter", "buyer", "buzz", "cabbage", "cabin", "cable", "cactus", "cage", "cake", "call", "calm", "camera", "camp", "can", "canal", "cancel", "candy", "cannon", "canoe", "canvas", "canyon", "capable", "capital", "captain", "car", "carbon", "card", "cargo", "carpet", "carry", "cart", "case", "cash", "casino", "castle", "casual", "cat", "catalog", "catch", "category", "cattle", "caught", "cause", "caution", "cave", "ceiling", "celery", "cement", "census", "century", "cereal", "certain", "chair", "chalk", "champion", "change", "chaos", "chapter", "charge", "chase", "chat", "cheap", "check", "cheese", "chef", "cherry", "chest", "chicken", "chief", "child", "chimney", "choice", "choose", "chronic", "chuckle", "chunk", "churn", "cigar", "cinnamon", "circle", "citizen", "city", "civil", "claim", "clap", "clarify", "claw", "clay", "clean", "clerk", "clever", "click", "client", "cliff", "climb", "clinic", "clip", "clock", "clog", "close", "cloth", "cloud", "clown", "club", "clump", "cluster", "clutch", "coach", "coast", "coconut", "code", "coffee", "coil", "coin", "collect", "color", "column", "combine", "come", "comfort", "comic", "common", "company", "concert", "conduct", "confirm", "congress", "connect", "consider", "control", "convince", "cook", "cool", "copper", "copy", "coral", "core", "corn", "correct", "cost", "cotton", "couch", "country", "couple", "course", "cousin", "cover", "coyote", "crack", "cradle", "craft", "cram", "crane", "crash", "crater", "crawl", "crazy", "cream", "credit", "creek", "crew", "cricket", "crime", "crisp", "critic", "crop", "cross", "crouch", "crowd", "crucial", "cruel", "cruise", "crumble", "crunch", "crush", "cry", "crystal", "cube", "culture", "cup", "cupboard", "curious", "current", "curtain", "curve", "cushion", "custom", "cute", "cycle", "dad", "damage", "damp", "dance", "danger", "daring", "dash", "daughter", "dawn", "day", "deal", "debate", "debris", "decade", "december", "decide", "decline", "decorate", "decrease", "deer", "defense", "define", "defy", "degree", "delay", "deliver", "demand", "demise", "denial", "dentist", "deny", "depart", "depend", "deposit", "depth", "deputy", "derive", "describe", "desert", "design", "desk", "despair", "destroy", "detail", "detect", "develop", "device", "devote", "diagram", "dial", "diamond", "diary", "dice", "diesel", "diet", "differ", "digital", "dignity", "dilemma", "dinner", "dinosaur", "direct", "dirt", "disagree", "discover", "disease", "dish", "dismiss", "disorder", "display", "distance", "divert", "divide", "divorce", "dizzy", "doctor", "document", "dog", "doll", "dolphin", "domain", "donate", "donkey", "donor", "door", "dose", "double", "dove", "draft", "dragon", "drama", "drastic", "draw", "dream", "dress", "drift", "drill", "drink", "drip", "drive", "drop", "drum", "dry", "duck", "dumb", "dune", "during", "dust", "dutch", "duty", "dwarf", "dynamic", "eager", "eagle", "early", "earn", "earth", "easily", "east", "easy", "echo", "ecology", "economy", "edge", "edit", "educate", "effort", "egg", "eight", "either", "elbow", "elder", "electric", "elegant", "element", "elephant", "elevator", "elite", "else", "embark", "embody", "embrace", "emerge", "emotion", "employ", "empower", "empty", "enable", "enact", "end", "endless", "endorse", "enemy", "energy", "enforce", "engage", "engine", "enhance", "enjoy", "enlist", "enough", "enrich", "enroll", "ensure", "enter", "entire", "entry", "envelope", "episode", "equal", "equip", "era", "erase", "erode", "erosion", "error", "erupt", "escape", "essay", "essence", "estate", "eternal", "ethics", "evidence", "evil", "evoke", "evolve", "exact", "example", "excess", "exchange", "excite", "exclude", "excuse", "execute", "exercise", "exhaust", "exhibit", "exile", "exist", "exit", "exotic", "expand", "expect", "expire", "explain", "expose", "express", "extend", "extra", "eye", "eyebrow", "fabric", "face", "faculty", "fade", "faint", "faith", "fall", "false", "fame", "family", "famous", "fan", "fancy", "fantasy", "farm", "fashion", "fat", "fatal", "father", "fatigue", "fault", "favorite", "feature", "february", "federal", "fee", "feed", "feel", "female", "fence", "festival", "fetch", "fever", "few", "fiber", "fiction", "field", "figure", "file", "film", "filter", "final", "find", "fine", "finger", "finish", "fire", "firm", "first", "fiscal", "fish", "fit", "fitness", "fix", "flag", "flame", "flash", "flat", "flavor", "flee", "flight", "flip", "float", "flock", "floor", "flower", "fluid", "flush", "fly", "foam", "focus", "fog", "foil", "fold", "follow", "food", "foot", "force", "forest", "forget", "fork", "fortune", "forum", "forward", "fossil", "foster", "found", "fox", "fragile", "frame", "frequent", "fresh", "friend", "fringe", "frog", "front", "frost", "frown", "frozen", "fruit", "fuel", "fun", "funny", "furnace", "fury", "future", "gadget", "gain", "galaxy", "gallery", "game", "gap", "garage", "garbage", "garden", "garlic", "garment", "gas", "gasp", "gate", "gather", "gauge", "gaze", "general", "genius", "genre", "gentle", "genuine", "gesture", "ghost", "giant", "gift", "giggle", "ginger", "giraffe", "girl", "give", "glad", "glance", "glare", "glass", "glide", "glimpse", "globe", "gloom", "glory", "glove", "glow", "glue", "goat", "goddess", "gold", "good", "goose", "gorilla", "gospel", "gossip", "govern", "gown", "grab", "grace", "grain", "grant", "grape", "grass", "gravity", "great", "green", "grid", "grief", "grit", "grocery", "group", "grow", "grunt", "guard", "guess", "guide", "guilt", "guitar", "gun", "gym", "habit", "hair", "half", "hammer", "hamster", "hand", "happy", "harbor", "hard", "harsh", "harvest", "hat", "have", "hawk", "hazard", "head", "health", "heart", "heavy", "hedgehog", "height", "hello", "helmet", "help", "hen", "hero", "hidden", "high", "hill", "hint", "hip", "hire", "history", "hobby", "hockey", "hold", "hole", "holiday", "hollow", "home", "honey", "hood", "hope", "horn", "horror", "horse", "hospital", "host", "hotel", "hour", "hover", "hub", "huge", "human", "humble", "humor", "hundred", "hungry", "hunt", "hurdle", "hurry", "hurt", "husband", "hybrid", "ice", "icon", "idea", "identify", "idle", "ignore", "ill", "illegal", "illness", "image", "imitate", "immense", "immune", "impact", "impose", "improve", "impulse", "inch", "include", "income", "increase", "index", "indicate", "indoor", "industry", "infant", "inflict", "inform", "inhale", "inherit", "initial", "inject", "injury", "inmate", "inner", "innocent", "input", "inquiry", "insane", "insect", "inside", "inspire", "install", "intact", "interest", "into", "invest", "invite", "involve", "iron", "island", "isolate", "issue", "item", "ivory", "jacket", "jaguar", "jar", "jazz", "jealous", "jeans", "jelly", "jewel", "job", "join", "joke", "journey", "joy", "judge", "juice", "jump", "jungle", "junior", "junk", "just", "kangaroo", "keen", "keep", "ketchup", "key", "kick", "kid", "kidney", "kind", "kingdom", "kiss", "kit", "kitchen", "kite", "kitten", "kiwi", "knee", "knife", "knock", "know", "lab", "label", "labor", "ladder", "lady", "lake", "lamp", "language", "laptop", "large", "later", "latin", "laugh", "laundry", "lava", "law", "lawn", "lawsuit", "layer", "lazy", "leader", "leaf", "learn", "leave", "lecture", "left", "leg", "legal", "legend", "leisure", "lemon", "lend", "length", "lens", "leopard", "lesson", "letter", "level", "liar", "liberty", "library", "license", "life", "lift", "light", "like", "limb", "limit", "link", "lion", "liquid", "list", "little", "live", "lizard", "load", "loan", "lobster", "local", "lock", "logic", "lonely", "long", "loop", "lottery", "loud", "lounge", "love", "loyal", "lucky", "luggage", "lumber", "lunar", "lunch", "luxury", "lyrics", "machine", "mad", "magic", "magnet", "maid", "mail", "main", "major", "make", "mammal", "man", "manage", "mandate", "mango", "mansion", "manual", "maple", "marble", "march", "margin", "marine", "market", "marriage", "mask", "mass", "master", "match", "material", "math", "matrix", "matter", "maximum", "maze", "meadow", "mean", "measure", "meat", "mechanic", "medal", "media", "melody", "melt", "member", "memory", "mention", "menu", "mercy", "merge", "merit", "merry", "mesh", "message", "metal", "method", "middle", "midnight", "milk", "million", "mimic", "mind", "minimum", "minor", "minute", "miracle", "mirror", "misery", "miss", "mistake", "mix", "mixed", "mixture", "mobile", "model", "modify", "mom", "moment", "monitor", "monkey", "monster", "month", "moon", "moral", "more", "morning", "mosquito", "mother", "motion", "motor", "mountain", "mouse", "move", "movie", "much", "muffin", "mule", "multiply", "muscle", "museum", "mushroom", "music", "must", "mutual", "myself", "mystery", "myth", "naive", "name", "napkin", "narrow", "nasty", "nation", "nature", "near", "neck", "need", "negative", "neglect", "neither", "nephew", "nerve", "nest", "net", "network", "neutral", "never", "news", "next", "nice", "night", "noble", "noise", "nominee", "noodle", "normal", "north", "nose", "notable", "note", "nothing", "notice", "novel", "now", "nuclear", "number", "nurse", "nut", "oak", "obey", "object", "oblige", "obscure", "observe", "obtain", "obvious", "occur", "ocean", "october", "odor", "off", "offer", "office", "often", "oil", "okay", "old", "olive", "olympic", "omit", "once", "one", "onion", "online", "only", "open", "opera", "opinion", "oppose", "option", "orange", "orbit", "orchard", "order", "ordinary", "organ", "orient", "original", "orphan", "ostrich", "other", "outdoor", "outer", "output", "outside", "oval", "oven", "over", "own", "owner", "oxygen", "oyster", "ozone", "pact", "paddle", "page", "pair", "palace", "palm", "panda", "panel", "panic", "panther", "paper", "parade", "parent", "park", "parrot", "party", "pass", "patch", "path", "patient", "patrol", "pattern", "pause", "pave", "payment", "peace", "peanut", "pear", "peasant", "pelican", "pen", "penalty", "pencil", "people", "pepper", "perfect", "permit", "person", "pet", "phone", "photo", "phrase", "physical", "piano", "picnic", "picture", "piece", "pig", "pigeon", "pill", "pilot", "pink", "pioneer", "pipe", "pistol", "pitch", "pizza", "place", "planet", "plastic", "plate", "play", "please", "pledge", "pluck", "plug", "plunge", "poem", "poet", "point", "polar", "pole", "police", "pond", "pony", "pool", "popular", "portion", "position", "possible", "post", "potato", "pottery", "poverty", "powder", "power", "practice", "praise", "predict", "prefer", "prepare", "present", "pretty", "prevent", "price", "pride", "primary", "print", "priority", "prison", "private", "prize", "problem", "process", "produce", "profit", "program", "project", "promote", "proof", "property", "prosper", "protect", "proud", "provide", "public", "pudding", "pull", "pulp", "pulse", "pumpkin", "punch", "pupil", "puppy", "purchase", "purity", "purpose", "purse", "push", "put", "puzzle", "pyramid", "quality", "quantum", "quarter", "question", "quick", "quit", "quiz", "quote", "rabbit", "raccoon", "race", "rack", "radar", "radio", "rail", "rain", "raise", "rally", "ramp", "ranch", "random", "range", "rapid", "rare", "rate", "rather", "raven", "raw", "razor", "ready", "real", "reason", "rebel", "rebuild", "recall", "receive", "recipe", "record", "recycle", "reduce", "reflect", "reform", "refuse", "region", "regret", "regular", "reject", "relax", "release", "relief", "rely", "remain", "remember", "remind", "remove", "render", "renew", "rent", "reopen", "repair", "repeat", "replace", "report", "require", "rescue", "resemble", "resist", "resource", "response", "result", "retire", "retreat", "return", "reunion", "reveal", "review", "reward", "rhythm", "rib", "ribbon", "rice", "rich", "ride", "ridge", "rifle", "right", "rigid", "ring", "riot", "ripple", "risk", "ritual", "rival", "river", "road", "roast", "robot", "robust", "rocket", "romance", "roof", "rookie", "room", "rose", "rotate", "rough", "round", "route", "royal", "rubber", "rude", "rug", "rule", "run", "runway", "rural", "sad", "saddle", "sadness", "safe", "sail", "salad", "salmon", "salon", "salt", "salute", "same", "sample", "sand", "satisfy", "satoshi", "sauce", "sausage", "save", "say", "scale", "scan", "scare", "scatter", "scene", "scheme", "school", "science", "scissors", "scorpion", "scout", "scrap", "screen", "script", "scrub", "sea", "search", "season", "seat", "second", "secret", "section", "security", "seed", "seek", "segment", "select", "sell", "seminar", "senior", "sense", "sentence", "series", "service", "session", "settle", "setup", "seven", "shadow", "shaft", "shallow", "share", "shed", "shell", "sheriff", "shield", "shift", "shine", "ship", "shiver", "shock", "shoe", "shoot", "shop", "short", "shoulder", "shove", "shrimp", "shrug", "shuffle", "shy", "sibling", "sick", "side", "siege", "sight", "sign", "silent", "silk", "silly", "silver", "similar", "simple", "since", "sing", "siren", "sister", "situate", "six", "size", "skate", "sketch", "ski", "skill", "skin", "skirt", "skull", "slab", "slam", "sleep", "slender", "slice", "slide", "slight", "slim", "slogan", "slot", "slow", "slush", "small", "smart", "smile", "smoke", "smooth", "snack", "snake", "snap", "sniff", "snow", "soap", "soccer", "social", "sock", "soda", "soft", "solar", "soldier", "solid", "solution", "solve", "someone", "song", "soon", "sorry", "sort", "soul", "sound", "soup", "source", "south", "space", "spare", "spatial", "spawn", "speak", "special", "speed", "spell", "spend", "sphere", "spice", "spider", "spike", "spin", "spirit", "split", "spoil", "sponsor", "spoon", "sport", "spot", "spray", "spread", "spring", "spy", "square", "squeeze", "squirrel", "stable", "stadium", "staff", "stage", "stairs", "stamp", "stand", "start", "state", "stay", "steak", "steel", "stem", "step", "stereo", "stick", "still", "sting", "stock", "stomach", "stone", "stool", "story", "stove", "strategy", "street", "strike", "strong", "struggle", "student", "stuff", "stumble", "style", "subject", "submit", "subway", "success", "such", "sudden", "suffer", "sugar", "suggest", "suit", "summer", "sun", "sunny", "sunset", "super", "supply", "supreme", "sure", "surface", "surge", "surprise", "surround", "survey", "suspect", "sustain", "swallow", "swamp", "swap", "swarm", "swear", "sweet", "swift", "swim", "swing", "switch", "sword", "symbol", "symptom", "syrup", "system", "table", "tackle", "tag", "tail", "talent", "talk", "tank", "tape", "target", "task", "taste", "tattoo", "taxi", "teach", "team", "tell", "ten", "tenant", "tennis", "tent", "term", "test", "text", "thank", "that", "theme", "then", "theory", "there", "they", "thing", "this", "thought", "three", "thrive", "throw", "thumb", "thunder", "ticket", "tide", "tiger", "tilt", "timber", "time", "tiny", "tip", "tired", "tissue", "title", "toast", "tobacco", "today", "toddler", "toe", "together", "toilet", "token", "tomato", "tomorrow", "tone", "tongue", "tonight", "tool", "tooth", "top", "topic", "topple", "torch", "tornado", "tortoise", "toss", "total", "tourist", "toward", "tower", "town", "toy", "track", "trade", "traffic", "tragic", "train", "transfer", "trap", "trash", "travel", "tray", "treat", "tree", "trend", "trial", "tribe", "trick", "trigger", "trim", "trip", "trophy", "trouble", "truck", "true", "truly", "trumpet", "trust", "truth", "try", "tube", "tuition", "tumble", "tuna", "tunnel", "turkey", "turn", "turtle", "twelve", "twenty", "twice", "twin", "twist", "two", "type", "typical", "ugly", "umbrella", "unable", "unaware", "uncle", "uncover", "under", "undo", "unfair", "unfold", "unhappy", "uniform", "unique", "unit", "universe", "unknown", "unlock", "until", "unusual", "unveil", "update", "upgrade", "uphold", "upon", "upper", "upset", "urban", "urge", "usage", "use", "used", "useful", "useless", "usual", "utility", "vacant", "vacuum", "vague", "valid", "valley", "valve", "van", "vanish", "vapor", "various", "vast", "vault", "vehicle", "velvet", "vendor", "venture", "venue", "verb", "verify", "version", "very", "vessel", "veteran", "viable", "vibrant", "vicious", "victory", "video", "view", "village", "vintage", "violin", "virtual", "virus", "visa", "visit", "visual", "vital", "vivid", "vocal", "voice", "void", "volcano", "volume", "vote", "voyage", "wage", "wagon", "wait", "walk", "wall", "walnut", "want", "warfare", "warm", "warrior", "wash", "wasp", "waste", "water", "wave", "way", "wealth", "weapon", "wear", "weasel", "weather", "web", "wedding", "weekend", "weird", "welcome", "west", "wet", "whale", "what", "wheat", "wheel", "when", "where", "whip", "whisper", "wide", "width", "wife", "wild", "will", "win", "window", "wine", "wing", "wink", "winner", "winter", "wire", "wisdom", "wise", "wish", "witness", "wolf", "woman", "wonder", "wood", "wool", "word", "work", "world", "worry", "worth", "wrap", "wreck", "wrestle", "wrist", "write", "wrong", "yard", "year", "yellow", "you", "young", "youth", "zebra", "zero", "zone", "zoo"};
@@ -204,15 +242,94 @@ typedef struct {
     uint8_t buffer_counter;
 } SHA256_CTX;
 
+#define SHA256_BACKEND_AUTO 0 // fastest backend the cpu supports
+#define SHA256_BACKEND_PORTABLE 1
+#define SHA256_BACKEND_SHANI 2
+#define SHA256_BACKEND_ARMV8 3
+
+const uint32_t sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+const uint32_t sha256_iv[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+const uint32_t sha256d64_pad_kw[64] = { // sha256_k plus the message schedule of the padding block that follows a 64 byte message, the same for every message
+    0xc28a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf374,
+    0x649b69c1, 0xf0fe4786, 0x0fe1edc6, 0x240cf254, 0x4fe9346f, 0x6cc984be, 0x61b9411e, 0x16f988fa,
+    0xf2c65152, 0xa88e5a6d, 0xb019fc65, 0xb9d99ec7, 0x9a1231c3, 0xe70eeaa0, 0xfdb1232b, 0xc7353eb0,
+    0x3069bad5, 0xcb976d5f, 0x5a0f118f, 0xdc1eeefd, 0x0a35b689, 0xde0b7a04, 0x58f4ca9d, 0xe15d5b16,
+    0x007f3e86, 0x37088980, 0xa507ea32, 0x6fab9537, 0x17406110, 0x0d8cd6f1, 0xcdaa3b6d, 0xc0bbbe37,
+    0x83613bda, 0xdb48a363, 0x0b02e931, 0x6fd15ca7, 0x521afaca, 0x31338431, 0x6ed41a95, 0x6d437890,
+    0xc39c91f2, 0x9eccabbd, 0xb5c9a0e6, 0x532fb63c, 0xd2c741c6, 0x07237ea3, 0xa4954b68, 0x4c191d76,
+};
+
+void (*HASH_ATOMIC sha256_blocks_impl)(uint32_t *, const uint8_t *, size_t) = NULL; // compression backend, picked by sha256_set_backend on first use, threads hashing for the first time at once may all pick it and store the same pointer
+
+#define SHA256_LANES_AUTO 0 // widest lane kernel the cpu supports, or one message at a time when that is faster
+#define SHA256_LANES_NONE 1 // one message at a time through sha256_blocks
+#define SHA256_LANES_BASE 2 // baseline simd, sse2 on x86-64 and neon on arm64
+#define SHA256_LANES_AVX2 3
+#define SHA256_LANES_AVX512 4
+
+#if SHA256_LANES
+typedef uint32_t sha256_lanes_t __attribute__((vector_size(4 * SHA256_LANES))); // one 32 bit word of every lane
+#define SHA256_LANES_ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+#define SHA256_LANES_ROUND(a, b, c, d, e, f, g, h, kw) \
+    t1 = h + (SHA256_LANES_ROTR(e, 6) ^ SHA256_LANES_ROTR(e, 11) ^ SHA256_LANES_ROTR(e, 25)) + ((e & f) ^ (~e & g)) + (kw); \
+    t2 = (SHA256_LANES_ROTR(a, 2) ^ SHA256_LANES_ROTR(a, 13) ^ SHA256_LANES_ROTR(a, 22)) + ((a & b) ^ (a & c) ^ (b & c)); \
+    d += t1; \
+    h = t1 + t2
+#endif
+
+void (*HASH_ATOMIC sha256_lanes_impl)(uint32_t *, const uint8_t *) = NULL; // lane kernel for sha256_many, NULL hashes one message at a time
+void (*HASH_ATOMIC sha256_lanes_kw_impl)(uint32_t *, const uint32_t *) = NULL; // lane kernel for a constant block with a precomputed schedule, set together with sha256_lanes_impl
+HASH_ATOMIC int32_t sha256_lanes_ready = 0; // 0 unset, 1 picked by SHA256_LANES_AUTO, 2 forced, set with release after both kernels, read with acquire before them
+
 uint32_t rotr32(uint32_t, int);
 uint32_t sha256_f1(uint32_t, uint32_t, uint32_t);
 uint32_t sha256_f2(uint32_t, uint32_t, uint32_t);
 void update_w(uint32_t *, int, const uint8_t *);
-void sha256_block(SHA256_CTX *);
+void sha256_block(uint32_t *, const uint8_t *);
+void sha256_block_kw(uint32_t *, const uint32_t *);
+void sha256_blocks_portable(uint32_t *, const uint8_t *, size_t);
+#if SHA256_SHANI
+void sha256_blocks_shani(uint32_t *, const uint8_t *, size_t);
+void sha256d64_shani(const uint8_t *, uint8_t *);
+#endif
+#if SHA256_ARMV8
+void sha256_blocks_armv8(uint32_t *, const uint8_t *, size_t);
+#endif
+int32_t sha256_backend_supported(int32_t);
+int32_t sha256_set_backend(int32_t);
+void sha256_blocks(uint32_t *, const uint8_t *, size_t);
+#if SHA256_LANES
+void sha256_lanes_block(uint32_t *, const uint8_t *);
+void sha256_lanes_block_kw(uint32_t *, const uint32_t *);
+#if defined(__x86_64__) || defined(__i386__)
+void sha256_lanes_block_avx2(uint32_t *, const uint8_t *);
+void sha256_lanes_block_avx512(uint32_t *, const uint8_t *);
+void sha256_lanes_block_kw_avx2(uint32_t *, const uint32_t *);
+void sha256_lanes_block_kw_avx512(uint32_t *, const uint32_t *);
+#endif
+#endif
+int32_t sha256_lanes_supported(int32_t);
+int32_t sha256_set_lanes(int32_t);
+void sha256_pad_block(uint8_t *, const uint8_t *, size_t, size_t);
+void sha256_many(const uint8_t *const *, size_t, size_t, uint8_t *);
 void sha256_init(SHA256_CTX *);
 void sha256_append(SHA256_CTX *, const uint8_t *, size_t);
 void sha256_finalize(SHA256_CTX *, uint8_t *);
 void sha256(const uint8_t *, size_t, uint8_t *);
+void sha256d64(const uint8_t *, size_t, uint8_t *);
+void sha256d(const uint8_t *, size_t, uint8_t *);
 
 uint32_t rotr32(uint32_t x, int n)
 {
@@ -247,34 +364,23 @@ void update_w(uint32_t *w, int i, const uint8_t *block)
     }
 }
 
-void sha256_block(SHA256_CTX *ctx)
+void sha256_block(uint32_t *state, const uint8_t *block) // compress one 64 byte block into state
 {
     int i, j;
     uint32_t a, b, c, d, e, f, g, h, w[16], temp;
+    const uint32_t *k = sha256_k;
 
-    static const uint32_t k[8 * 8] = {
-        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
-        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
-        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
-        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
-        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
-        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
-        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
-        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
-    };
-
-    a = ctx->state[0];
-    b = ctx->state[1];
-    c = ctx->state[2];
-    d = ctx->state[3];
-    e = ctx->state[4];
-    f = ctx->state[5];
-    g = ctx->state[6];
-    h = ctx->state[7];
-    w[16];
+    a = state[0];
+    b = state[1];
+    c = state[2];
+    d = state[3];
+    e = state[4];
+    f = state[5];
+    g = state[6];
+    h = state[7];
 
     for (i = 0; i < 64; i += 16) {
-        update_w(w, i, ctx->block);
+        update_w(w, i, block);
 
         for (j = 0; j < 16; j += 4) {
             temp = h + sha256_f1(e, f, g) + k[i + j + 0] + w[j + 0];
@@ -292,65 +398,583 @@ void sha256_block(SHA256_CTX *ctx)
         }
     }
 
-    ctx->state[0] += a;
-    ctx->state[1] += b;
-    ctx->state[2] += c;
-    ctx->state[3] += d;
-    ctx->state[4] += e;
-    ctx->state[5] += f;
-    ctx->state[6] += g;
-    ctx->state[7] += h;
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+void sha256_block_kw(uint32_t *state, const uint32_t *kw) // compress a block whose sha256_k plus message schedule kw[64] is known in advance, as for constant padding blocks
+{
+    int i;
+    uint32_t a, b, c, d, e, f, g, h, temp;
+
+    a = state[0];
+    b = state[1];
+    c = state[2];
+    d = state[3];
+    e = state[4];
+    f = state[5];
+    g = state[6];
+    h = state[7];
+
+    for (i = 0; i < 64; i += 4) {
+        temp = h + sha256_f1(e, f, g) + kw[i + 0];
+        h = temp + d;
+        d = temp + sha256_f2(a, b, c);
+        temp = g + sha256_f1(h, e, f) + kw[i + 1];
+        g = temp + c;
+        c = temp + sha256_f2(d, a, b);
+        temp = f + sha256_f1(g, h, e) + kw[i + 2];
+        f = temp + b;
+        b = temp + sha256_f2(c, d, a);
+        temp = e + sha256_f1(f, g, h) + kw[i + 3];
+        e = temp + a;
+        a = temp + sha256_f2(b, c, d);
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+void sha256_blocks_portable(uint32_t *state, const uint8_t *blocks, size_t n) // compress n consecutive 64 byte blocks into state in plain c
+{
+    while (n--) {
+        sha256_block(state, blocks);
+        blocks += 64;
+    }
+}
+
+#if SHA256_SHANI
+__attribute__((target("sha,sse4.1,ssse3")))
+void sha256_blocks_shani(uint32_t *state, const uint8_t *blocks, size_t n) // compress n blocks with the x86 sha extensions, 4 rounds per pair of sha256rnds2
+{
+    __m128i state0, state1, abef, cdgh, msg, t, w[4];
+    const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL); // big endian words
+    size_t g;
+
+    t = _mm_loadu_si128((const __m128i *)&state[0]); // the instructions want the state as abef and cdgh
+    state1 = _mm_loadu_si128((const __m128i *)&state[4]);
+    t = _mm_shuffle_epi32(t, 0xB1); // cdab
+    state1 = _mm_shuffle_epi32(state1, 0x1B); // efgh
+    state0 = _mm_alignr_epi8(t, state1, 8); // abef
+    state1 = _mm_blend_epi16(state1, t, 0xF0); // cdgh
+
+    while (n--) {
+        abef = state0;
+        cdgh = state1;
+        for (g = 0; g < 16; g++) { // w[g & 3] holds message words 4g..4g+3
+            if (g < 4) {
+                w[g] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(blocks + 16 * g)), mask);
+            } else {
+                t = _mm_sha256msg1_epu32(w[g & 3], w[(g + 1) & 3]);
+                t = _mm_add_epi32(t, _mm_alignr_epi8(w[(g + 3) & 3], w[(g + 2) & 3], 4));
+                w[g & 3] = _mm_sha256msg2_epu32(t, w[(g + 3) & 3]);
+            }
+            msg = _mm_add_epi32(w[g & 3], _mm_loadu_si128((const __m128i *)&sha256_k[4 * g]));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(msg, 0x0E));
+        }
+        state0 = _mm_add_epi32(state0, abef);
+        state1 = _mm_add_epi32(state1, cdgh);
+        blocks += 64;
+    }
+
+    t = _mm_shuffle_epi32(state0, 0x1B); // feba
+    state1 = _mm_shuffle_epi32(state1, 0xB1); // dchg
+    state0 = _mm_blend_epi16(t, state1, 0xF0); // dcba
+    state1 = _mm_alignr_epi8(state1, t, 8); // hgfe
+    _mm_storeu_si128((__m128i *)&state[0], state0);
+    _mm_storeu_si128((__m128i *)&state[4], state1);
+}
+
+__attribute__((target("sha,sse4.1,ssse3")))
+void sha256d64_shani(const uint8_t *in, uint8_t *out) // out[0..63] = sha256d64 of the two 64 byte messages in[0..127], their rounds interleaved to hide the sha256rnds2 latency and the state kept in abef and cdgh order throughout
+{
+    __m128i state0[2], state1[2], abef[2], cdgh[2], msg[2], t, w[2][4];
+    const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    const __m128i iv0 = _mm_set_epi32(0x6a09e667, 0xbb67ae85, 0x510e527f, 0x9b05688c); // sha256_iv as abef and cdgh
+    const __m128i iv1 = _mm_set_epi32(0x3c6ef372, 0xa54ff53a, 0x1f83d9ab, 0x5be0cd19);
+    size_t g, m;
+
+    for (m = 0; m < 2; m++) { // first block, the messages
+        state0[m] = iv0;
+        state1[m] = iv1;
+    }
+    for (g = 0; g < 16; g++) {
+        for (m = 0; m < 2; m++) {
+            if (g < 4) {
+                w[m][g] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(in + 64 * m + 16 * g)), mask);
+            } else {
+                t = _mm_sha256msg1_epu32(w[m][g & 3], w[m][(g + 1) & 3]);
+                t = _mm_add_epi32(t, _mm_alignr_epi8(w[m][(g + 3) & 3], w[m][(g + 2) & 3], 4));
+                w[m][g & 3] = _mm_sha256msg2_epu32(t, w[m][(g + 3) & 3]);
+            }
+            msg[m] = _mm_add_epi32(w[m][g & 3], _mm_loadu_si128((const __m128i *)&sha256_k[4 * g]));
+        }
+        for (m = 0; m < 2; m++) state1[m] = _mm_sha256rnds2_epu32(state1[m], state0[m], msg[m]);
+        for (m = 0; m < 2; m++) state0[m] = _mm_sha256rnds2_epu32(state0[m], state1[m], _mm_shuffle_epi32(msg[m], 0x0E));
+    }
+    for (m = 0; m < 2; m++) {
+        state0[m] = _mm_add_epi32(state0[m], iv0);
+        state1[m] = _mm_add_epi32(state1[m], iv1);
+        abef[m] = state0[m];
+        cdgh[m] = state1[m];
+    }
+
+    for (g = 0; g < 16; g++) { // second block, the padding, with its schedule from sha256d64_pad_kw
+        msg[0] = _mm_loadu_si128((const __m128i *)&sha256d64_pad_kw[4 * g]);
+        for (m = 0; m < 2; m++) state1[m] = _mm_sha256rnds2_epu32(state1[m], state0[m], msg[0]);
+        for (m = 0; m < 2; m++) state0[m] = _mm_sha256rnds2_epu32(state0[m], state1[m], _mm_shuffle_epi32(msg[0], 0x0E));
+    }
+    for (m = 0; m < 2; m++) { // the first digest in message word order is the next block, no bytes in between
+        state0[m] = _mm_add_epi32(state0[m], abef[m]);
+        state1[m] = _mm_add_epi32(state1[m], cdgh[m]);
+        t = _mm_shuffle_epi32(state0[m], 0x1B); // feba
+        state1[m] = _mm_shuffle_epi32(state1[m], 0xB1); // dchg
+        w[m][0] = _mm_blend_epi16(t, state1[m], 0xF0); // dcba
+        w[m][1] = _mm_alignr_epi8(state1[m], t, 8); // hgfe
+        w[m][2] = _mm_set_epi32(0, 0, 0, 0x80000000);
+        w[m][3] = _mm_set_epi32(256, 0, 0, 0);
+        state0[m] = iv0;
+        state1[m] = iv1;
+    }
+    for (g = 0; g < 16; g++) { // third block, the digest and its padding
+        for (m = 0; m < 2; m++) {
+            if (g >= 4) {
+                t = _mm_sha256msg1_epu32(w[m][g & 3], w[m][(g + 1) & 3]);
+                t = _mm_add_epi32(t, _mm_alignr_epi8(w[m][(g + 3) & 3], w[m][(g + 2) & 3], 4));
+                w[m][g & 3] = _mm_sha256msg2_epu32(t, w[m][(g + 3) & 3]);
+            }
+            msg[m] = _mm_add_epi32(w[m][g & 3], _mm_loadu_si128((const __m128i *)&sha256_k[4 * g]));
+        }
+        for (m = 0; m < 2; m++) state1[m] = _mm_sha256rnds2_epu32(state1[m], state0[m], msg[m]);
+        for (m = 0; m < 2; m++) state0[m] = _mm_sha256rnds2_epu32(state0[m], state1[m], _mm_shuffle_epi32(msg[m], 0x0E));
+    }
+    for (m = 0; m < 2; m++) {
+        state0[m] = _mm_add_epi32(state0[m], iv0);
+        state1[m] = _mm_add_epi32(state1[m], iv1);
+        t = _mm_shuffle_epi32(state0[m], 0x1B);
+        state1[m] = _mm_shuffle_epi32(state1[m], 0xB1);
+        _mm_storeu_si128((__m128i *)(out + 32 * m), _mm_shuffle_epi8(_mm_blend_epi16(t, state1[m], 0xF0), mask));
+        _mm_storeu_si128((__m128i *)(out + 32 * m + 16), _mm_shuffle_epi8(_mm_alignr_epi8(state1[m], t, 8), mask));
+    }
+}
+#endif
+
+#if SHA256_ARMV8
+#if defined(__clang__)
+__attribute__((target("crypto")))
+#else
+__attribute__((target("+crypto")))
+#endif
+void sha256_blocks_armv8(uint32_t *state, const uint8_t *blocks, size_t n) // compress n blocks with the armv8 sha2 instructions, 4 rounds per sha256h and sha256h2 pair
+{
+    uint32x4_t state0, state1, abcd, efgh, msg, t, w[4];
+    size_t g;
+
+    state0 = vld1q_u32(&state[0]);
+    state1 = vld1q_u32(&state[4]);
+
+    while (n--) {
+        abcd = state0;
+        efgh = state1;
+        for (g = 0; g < 16; g++) {
+            if (g < 4) {
+                w[g] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(blocks + 16 * g))); // big endian words
+            } else {
+                w[g & 3] = vsha256su1q_u32(vsha256su0q_u32(w[g & 3], w[(g + 1) & 3]), w[(g + 2) & 3], w[(g + 3) & 3]);
+            }
+            msg = vaddq_u32(w[g & 3], vld1q_u32(&sha256_k[4 * g]));
+            t = state0;
+            state0 = vsha256hq_u32(state0, state1, msg);
+            state1 = vsha256h2q_u32(state1, t, msg);
+        }
+        state0 = vaddq_u32(state0, abcd);
+        state1 = vaddq_u32(state1, efgh);
+        blocks += 64;
+    }
+
+    vst1q_u32(&state[0], state0);
+    vst1q_u32(&state[4], state1);
+}
+#endif
+
+int32_t sha256_backend_supported(int32_t backend) // return 1 if this build and cpu can run the backend, return 0 otherwise
+{
+#if SHA256_SHANI
+    uint32_t eax, ebx, ecx, edx;
+#endif
+
+    switch (backend) {
+        case SHA256_BACKEND_AUTO:
+        case SHA256_BACKEND_PORTABLE:
+            return 1;
+#if SHA256_SHANI
+        case SHA256_BACKEND_SHANI:
+            if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & (1 << 19)) || !(ecx & (1 << 9))) return 0; // sse4.1 and ssse3
+            if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return 0;
+            return (ebx >> 29) & 1; // sha
+#endif
+#if SHA256_ARMV8
+        case SHA256_BACKEND_ARMV8:
+#if defined(__APPLE__)
+            return 1; // every apple arm64 core has them
+#else
+            return (getauxval(AT_HWCAP) & (1 << 6)) != 0; // HWCAP_SHA2
+#endif
+#endif
+        default:
+            return 0;
+    }
+}
+
+int32_t sha256_set_backend(int32_t backend) // select the compression backend, SHA256_BACKEND_AUTO picks the fastest supported one and the others force one for testing, return 0 and keep the current one if it is not supported
+{
+    int32_t lanes_auto = 1;
+
+    if (!sha256_backend_supported(backend)) return 0;
+
+    if (backend == SHA256_BACKEND_AUTO) {
+        backend = SHA256_BACKEND_PORTABLE;
+        if (sha256_backend_supported(SHA256_BACKEND_SHANI)) backend = SHA256_BACKEND_SHANI;
+        if (sha256_backend_supported(SHA256_BACKEND_ARMV8)) backend = SHA256_BACKEND_ARMV8;
+    }
+
+    switch (backend) {
+#if SHA256_SHANI
+        case SHA256_BACKEND_SHANI:
+            sha256_blocks_impl = sha256_blocks_shani;
+            break;
+#endif
+#if SHA256_ARMV8
+        case SHA256_BACKEND_ARMV8:
+            sha256_blocks_impl = sha256_blocks_armv8;
+            break;
+#endif
+        default:
+            sha256_blocks_impl = sha256_blocks_portable;
+            break;
+    }
+    HASH_CAS(&sha256_lanes_ready, &lanes_auto, 0); // an automatic lane choice depends on the backend, pick it again on next use
+    return 1;
+}
+
+void sha256_blocks(uint32_t *state, const uint8_t *blocks, size_t n) // compress n consecutive 64 byte blocks into state with the selected backend
+{
+    void (*impl)(uint32_t *, const uint8_t *, size_t) = sha256_blocks_impl;
+
+    if (!impl) {
+        sha256_set_backend(SHA256_BACKEND_AUTO);
+        impl = sha256_blocks_impl;
+    }
+    impl(state, blocks, n);
+}
+
+#if SHA256_LANES
+void sha256_lanes_block(uint32_t *state, const uint8_t *blocks) // compress one 64 byte block for each of SHA256_LANES messages, state[j * SHA256_LANES + l] is word j of lane l, blocks holds the lanes one after another
+{
+    sha256_lanes_t v[8], w[16], a, b, c, d, e, f, g, h, t1, t2;
+    const uint8_t *p;
+    size_t i, l;
+
+    for (i = 0; i < 8; i++) memcpy(&v[i], state + i * SHA256_LANES, sizeof(sha256_lanes_t));
+    for (i = 0; i < 16; i++) { // transpose the big endian message words into lanes
+        for (l = 0; l < SHA256_LANES; l++) {
+            p = blocks + 64 * l + 4 * i;
+            w[i][l] = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+        }
+    }
+
+    a = v[0];
+    b = v[1];
+    c = v[2];
+    d = v[3];
+    e = v[4];
+    f = v[5];
+    g = v[6];
+    h = v[7];
+
+    for (i = 0; i < 64; i += 16) {
+        if (i) { // next 16 words of the message schedule
+            for (l = 0; l < 16; l++) {
+                t1 = w[(l + 1) & 15];
+                t2 = w[(l + 14) & 15];
+                w[l] += w[(l + 9) & 15] + (SHA256_LANES_ROTR(t1, 7) ^ SHA256_LANES_ROTR(t1, 18) ^ (t1 >> 3)) + (SHA256_LANES_ROTR(t2, 17) ^ SHA256_LANES_ROTR(t2, 19) ^ (t2 >> 10));
+            }
+        }
+        for (l = 0; l < 16; l += 8) { // the eight working variables trade roles instead of being moved
+            SHA256_LANES_ROUND(a, b, c, d, e, f, g, h, sha256_k[i + l] + w[l]);
+            SHA256_LANES_ROUND(h, a, b, c, d, e, f, g, sha256_k[i + l + 1] + w[l + 1]);
+            SHA256_LANES_ROUND(g, h, a, b, c, d, e, f, sha256_k[i + l + 2] + w[l + 2]);
+            SHA256_LANES_ROUND(f, g, h, a, b, c, d, e, sha256_k[i + l + 3] + w[l + 3]);
+            SHA256_LANES_ROUND(e, f, g, h, a, b, c, d, sha256_k[i + l + 4] + w[l + 4]);
+            SHA256_LANES_ROUND(d, e, f, g, h, a, b, c, sha256_k[i + l + 5] + w[l + 5]);
+            SHA256_LANES_ROUND(c, d, e, f, g, h, a, b, sha256_k[i + l + 6] + w[l + 6]);
+            SHA256_LANES_ROUND(b, c, d, e, f, g, h, a, sha256_k[i + l + 7] + w[l + 7]);
+        }
+    }
+
+    v[0] += a;
+    v[1] += b;
+    v[2] += c;
+    v[3] += d;
+    v[4] += e;
+    v[5] += f;
+    v[6] += g;
+    v[7] += h;
+    for (i = 0; i < 8; i++) memcpy(state + i * SHA256_LANES, &v[i], sizeof(sha256_lanes_t));
+}
+
+void sha256_lanes_block_kw(uint32_t *state, const uint32_t *kw) // sha256_block_kw for each of SHA256_LANES states, every lane compresses the same block
+{
+    sha256_lanes_t v[8], a, b, c, d, e, f, g, h, t1, t2;
+    size_t i;
+
+    for (i = 0; i < 8; i++) memcpy(&v[i], state + i * SHA256_LANES, sizeof(sha256_lanes_t));
+
+    a = v[0];
+    b = v[1];
+    c = v[2];
+    d = v[3];
+    e = v[4];
+    f = v[5];
+    g = v[6];
+    h = v[7];
+
+    for (i = 0; i < 64; i += 8) {
+        SHA256_LANES_ROUND(a, b, c, d, e, f, g, h, kw[i]);
+        SHA256_LANES_ROUND(h, a, b, c, d, e, f, g, kw[i + 1]);
+        SHA256_LANES_ROUND(g, h, a, b, c, d, e, f, kw[i + 2]);
+        SHA256_LANES_ROUND(f, g, h, a, b, c, d, e, kw[i + 3]);
+        SHA256_LANES_ROUND(e, f, g, h, a, b, c, d, kw[i + 4]);
+        SHA256_LANES_ROUND(d, e, f, g, h, a, b, c, kw[i + 5]);
+        SHA256_LANES_ROUND(c, d, e, f, g, h, a, b, kw[i + 6]);
+        SHA256_LANES_ROUND(b, c, d, e, f, g, h, a, kw[i + 7]);
+    }
+
+    v[0] += a;
+    v[1] += b;
+    v[2] += c;
+    v[3] += d;
+    v[4] += e;
+    v[5] += f;
+    v[6] += g;
+    v[7] += h;
+    for (i = 0; i < 8; i++) memcpy(state + i * SHA256_LANES, &v[i], sizeof(sha256_lanes_t));
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2"), flatten))
+void sha256_lanes_block_avx2(uint32_t *state, const uint8_t *blocks) // sha256_lanes_block on 8 wide registers
+{
+    sha256_lanes_block(state, blocks);
+}
+
+__attribute__((target("avx512f"), flatten))
+void sha256_lanes_block_avx512(uint32_t *state, const uint8_t *blocks) // sha256_lanes_block on 16 wide registers
+{
+    sha256_lanes_block(state, blocks);
+}
+
+__attribute__((target("avx2"), flatten))
+void sha256_lanes_block_kw_avx2(uint32_t *state, const uint32_t *kw) // sha256_lanes_block_kw on 8 wide registers
+{
+    sha256_lanes_block_kw(state, kw);
+}
+
+__attribute__((target("avx512f"), flatten))
+void sha256_lanes_block_kw_avx512(uint32_t *state, const uint32_t *kw) // sha256_lanes_block_kw on 16 wide registers
+{
+    sha256_lanes_block_kw(state, kw);
+}
+#endif
+#endif
+
+int32_t sha256_lanes_supported(int32_t lanes) // return 1 if this build and cpu can run the lane kernel, return 0 otherwise
+{
+    switch (lanes) {
+        case SHA256_LANES_AUTO:
+        case SHA256_LANES_NONE:
+            return 1;
+#if SHA256_LANES
+        case SHA256_LANES_BASE:
+            return 1;
+#if defined(__x86_64__) || defined(__i386__)
+        case SHA256_LANES_AVX2:
+            return __builtin_cpu_supports("avx2");
+        case SHA256_LANES_AVX512:
+            return __builtin_cpu_supports("avx512f");
+#endif
+#endif
+        default:
+            return 0;
+    }
+}
+
+int32_t sha256_set_lanes(int32_t lanes) // select the kernel of sha256_many, SHA256_LANES_AUTO picks the fastest for the selected compression backend and the others force one for testing, return 0 and keep the current one if it is not supported
+{
+    void (*impl)(uint32_t *, const uint8_t *, size_t);
+    int32_t ready = 2;
+
+    if (!sha256_lanes_supported(lanes)) return 0;
+
+    if (lanes == SHA256_LANES_AUTO) { // a single sha instruction stream beats the 4 and 8 wide kernels, not the 16 wide one
+        impl = sha256_blocks_impl;
+        if (!impl) {
+            sha256_set_backend(SHA256_BACKEND_AUTO);
+            impl = sha256_blocks_impl;
+        }
+        ready = 1;
+        lanes = sha256_lanes_supported(SHA256_LANES_BASE) ? SHA256_LANES_BASE : SHA256_LANES_NONE;
+        if (sha256_lanes_supported(SHA256_LANES_AVX2)) lanes = SHA256_LANES_AVX2;
+        if (impl != sha256_blocks_portable) lanes = SHA256_LANES_NONE; // every other backend runs on sha instructions
+        if (sha256_lanes_supported(SHA256_LANES_AVX512)) lanes = SHA256_LANES_AVX512;
+    }
+
+    switch (lanes) {
+#if SHA256_LANES
+        case SHA256_LANES_BASE:
+            sha256_lanes_impl = sha256_lanes_block;
+            sha256_lanes_kw_impl = sha256_lanes_block_kw;
+            break;
+#if defined(__x86_64__) || defined(__i386__)
+        case SHA256_LANES_AVX2:
+            sha256_lanes_impl = sha256_lanes_block_avx2;
+            sha256_lanes_kw_impl = sha256_lanes_block_kw_avx2;
+            break;
+        case SHA256_LANES_AVX512:
+            sha256_lanes_impl = sha256_lanes_block_avx512;
+            sha256_lanes_kw_impl = sha256_lanes_block_kw_avx512;
+            break;
+#endif
+#endif
+        default:
+            sha256_lanes_impl = NULL;
+            sha256_lanes_kw_impl = NULL;
+            break;
+    }
+    HASH_STORE_RELEASE(&sha256_lanes_ready, ready);
+    return 1;
+}
+
+void sha256_pad_block(uint8_t *block, const uint8_t *message, size_t len, size_t i) // block = 64 byte block i of message padded to whole blocks, the 0x80 byte, zeros and the bit length
+{
+    size_t off = 64 * i, n = 0, last = (len + 8) / 64;
+
+    if (off < len) {
+        n = len - off < 64 ? len - off : 64;
+        memcpy(block, message + off, n);
+    }
+    memset(block + n, 0, 64 - n);
+    if (len >= off && len - off < 64) block[len - off] = 0x80;
+    if (i == last) {
+        for (n = 0; n < 8; n++) block[56 + n] = ((uint64_t)len * 8 >> (56 - 8 * n)) & 0xff;
+    }
+}
+
+void sha256_many(const uint8_t *const *msgs, size_t len, size_t n, uint8_t *out) // out + 32 * i = sha256 of msgs[i] for n messages of len bytes each, SHA256_LANES messages at a time through the lane kernel
+{
+#if SHA256_LANES
+    uint32_t state[8 * SHA256_LANES];
+    uint8_t blocks[64 * SHA256_LANES];
+    size_t lanes, b, l, j, n_blocks = (len + 8) / 64 + 1;
+    void (*lanes_impl)(uint32_t *, const uint8_t *);
+#endif
+    size_t i = 0;
+
+    if (!HASH_LOAD_ACQUIRE(&sha256_lanes_ready)) sha256_set_lanes(SHA256_LANES_AUTO);
+
+#if SHA256_LANES
+    lanes_impl = sha256_lanes_impl;
+    if (lanes_impl) {
+        for (; n - i >= SHA256_LANES / 2; i += lanes) { // short tails go one at a time below
+            lanes = n - i < SHA256_LANES ? n - i : SHA256_LANES;
+            for (j = 0; j < 8; j++) {
+                for (l = 0; l < SHA256_LANES; l++) state[j * SHA256_LANES + l] = sha256_iv[j];
+            }
+            for (b = 0; b < n_blocks; b++) {
+                for (l = 0; l < SHA256_LANES; l++) sha256_pad_block(blocks + 64 * l, msgs[i + (l < lanes ? l : 0)], len, b); // idle lanes repeat the first message
+                lanes_impl(state, blocks);
+            }
+            for (l = 0; l < lanes; l++) {
+                for (j = 0; j < 8; j++) {
+                    out[32 * (i + l) + 4 * j] = state[j * SHA256_LANES + l] >> 24;
+                    out[32 * (i + l) + 4 * j + 1] = state[j * SHA256_LANES + l] >> 16;
+                    out[32 * (i + l) + 4 * j + 2] = state[j * SHA256_LANES + l] >> 8;
+                    out[32 * (i + l) + 4 * j + 3] = state[j * SHA256_LANES + l];
+                }
+            }
+        }
+    }
+#endif
+
+    for (; i < n; i++) sha256(msgs[i], len, out + 32 * i);
 }
 
 void sha256_init(SHA256_CTX *ctx)
 {
-    ctx->state[0] = 0x6a09e667;
-    ctx->state[1] = 0xbb67ae85;
-    ctx->state[2] = 0x3c6ef372;
-    ctx->state[3] = 0xa54ff53a;
-    ctx->state[4] = 0x510e527f;
-    ctx->state[5] = 0x9b05688c;
-    ctx->state[6] = 0x1f83d9ab;
-    ctx->state[7] = 0x5be0cd19;
+    memcpy(ctx->state, sha256_iv, sizeof(ctx->state));
     ctx->n_bits = 0;
     ctx->buffer_counter = 0;
 }
 
-void sha256_append_byte(SHA256_CTX *ctx, uint8_t byte)
+void sha256_append(SHA256_CTX *ctx, const uint8_t *message, size_t size) // hash whole blocks straight from message, only a partial tail is copied into ctx->block
 {
-    ctx->block[ctx->buffer_counter++] = byte;
-    ctx->n_bits += 8;
-
-    if (ctx->buffer_counter == 64) {
+    size_t n;
+
+    ctx->n_bits += (uint64_t)size * 8;
+
+    if (ctx->buffer_counter) { // top up the block left over from the previous call
+        n = 64 - ctx->buffer_counter;
+        if (n > size) n = size;
+        memcpy(ctx->block + ctx->buffer_counter, message, n);
+        ctx->buffer_counter += n;
+        message += n;
+        size -= n;
+        if (ctx->buffer_counter < 64) return;
+        sha256_blocks(ctx->state, ctx->block, 1);
         ctx->buffer_counter = 0;
-        sha256_block(ctx);
     }
-}
 
-void sha256_append(SHA256_CTX *ctx, const uint8_t *message, size_t size)
-{
-    int i;
-    for (i = 0; i < size; i++) {
-        sha256_append_byte(ctx, message[i]);
+    if (size >= 64) {
+        sha256_blocks(ctx->state, message, size / 64);
+        message += size & ~(size_t)63;
+        size &= 63;
     }
+
+    memcpy(ctx->block, message, size);
+    ctx->buffer_counter = size;
 }
 
 void sha256_finalize(SHA256_CTX *ctx, uint8_t *digest)
 {
-    uint8_t byte;
     int i;
     uint64_t n_bits = ctx->n_bits;
+    size_t n = ctx->buffer_counter;
 
-    sha256_append_byte(ctx, 0x80);
-
-    while (ctx->buffer_counter != 56) {
-        sha256_append_byte(ctx, 0);
+    ctx->block[n++] = 0x80;
+    if (n > 56) { // no room for the length, it goes in one more block
+        memset(ctx->block + n, 0, 64 - n);
+        sha256_blocks(ctx->state, ctx->block, 1);
+        n = 0;
     }
-
-    for (i = 7; i >= 0; i--) {
-        byte = (n_bits >> 8 * i) & 0xff;
-        sha256_append_byte(ctx, byte);
+    memset(ctx->block + n, 0, 56 - n);
+    for (i = 0; i < 8; i++) {
+        ctx->block[56 + i] = (n_bits >> (56 - 8 * i)) & 0xff; // message length in bits, big endian
     }
+    sha256_blocks(ctx->state, ctx->block, 1);
+    ctx->buffer_counter = 0;
 
     /* extract uint32_t state[8] into uint8_t digest[32] */
     for (i = 0; i < 8; i++) {
@@ -369,6 +993,124 @@ void sha256(const uint8_t *message, size_t size, uint8_t *digest)
     sha256_finalize(&ctx, digest);
 }
 
+void sha256d64(const uint8_t *in, size_t n, uint8_t *out) // out + 32 * i = sha256(sha256(in + 64 * i)) for n 64 byte messages, as for merkle tree nodes
+{
+#if SHA256_LANES
+    uint32_t lanes_state[8 * SHA256_LANES];
+    uint8_t blocks[64 * SHA256_LANES];
+    size_t lanes, l;
+    void (*lanes_impl)(uint32_t *, const uint8_t *);
+    void (*lanes_kw_impl)(uint32_t *, const uint32_t *);
+#endif
+    void (*blocks_impl)(uint32_t *, const uint8_t *, size_t) = sha256_blocks_impl;
+    uint32_t state[8];
+    uint8_t pad[64], block[64];
+    size_t i = 0, j;
+
+    if (!HASH_LOAD_ACQUIRE(&sha256_lanes_ready)) sha256_set_lanes(SHA256_LANES_AUTO);
+    if (!blocks_impl) {
+        sha256_set_backend(SHA256_BACKEND_AUTO);
+        blocks_impl = sha256_blocks_impl;
+    }
+
+    memset(pad, 0, 64); // padding block of a 64 byte message
+    pad[0] = 0x80;
+    pad[62] = 0x02; // 512 bits
+    memset(block + 32, 0, 32); // the second hash is a 32 byte digest and its padding in one block
+    block[32] = 0x80;
+    block[62] = 0x01; // 256 bits
+
+#if SHA256_LANES
+    lanes_impl = sha256_lanes_impl;
+    lanes_kw_impl = sha256_lanes_kw_impl;
+    if (lanes_impl && lanes_kw_impl) { // both or neither, unless sha256_set_lanes runs meanwhile
+        for (; n - i >= SHA256_LANES / 2; i += lanes) { // short tails go one at a time below
+            lanes = n - i < SHA256_LANES ? n - i : SHA256_LANES;
+            for (j = 0; j < 8; j++) {
+                for (l = 0; l < SHA256_LANES; l++) lanes_state[j * SHA256_LANES + l] = sha256_iv[j];
+            }
+            if (lanes == SHA256_LANES) {
+                lanes_impl(lanes_state, in + 64 * i); // the messages already sit one after another
+            } else {
+                for (l = 0; l < SHA256_LANES; l++) memcpy(blocks + 64 * l, in + 64 * (i + (l < lanes ? l : 0)), 64); // idle lanes repeat the first message
+                lanes_impl(lanes_state, blocks);
+            }
+            lanes_kw_impl(lanes_state, sha256d64_pad_kw);
+
+            for (l = 0; l < SHA256_LANES; l++) {
+                for (j = 0; j < 8; j++) {
+                    block[4 * j] = lanes_state[j * SHA256_LANES + l] >> 24;
+                    block[4 * j + 1] = lanes_state[j * SHA256_LANES + l] >> 16;
+                    block[4 * j + 2] = lanes_state[j * SHA256_LANES + l] >> 8;
+                    block[4 * j + 3] = lanes_state[j * SHA256_LANES + l];
+                }
+                memcpy(blocks + 64 * l, block, 64);
+            }
+            for (j = 0; j < 8; j++) {
+                for (l = 0; l < SHA256_LANES; l++) lanes_state[j * SHA256_LANES + l] = sha256_iv[j];
+            }
+            lanes_impl(lanes_state, blocks);
+
+            for (l = 0; l < lanes; l++) {
+                for (j = 0; j < 8; j++) {
+                    out[32 * (i + l) + 4 * j] = lanes_state[j * SHA256_LANES + l] >> 24;
+                    out[32 * (i + l) + 4 * j + 1] = lanes_state[j * SHA256_LANES + l] >> 16;
+                    out[32 * (i + l) + 4 * j + 2] = lanes_state[j * SHA256_LANES + l] >> 8;
+                    out[32 * (i + l) + 4 * j + 3] = lanes_state[j * SHA256_LANES + l];
+                }
+            }
+        }
+    }
+#endif
+
+#if SHA256_SHANI
+    if (blocks_impl == sha256_blocks_shani) {
+        for (; n - i >= 2; i += 2) sha256d64_shani(in + 64 * i, out + 32 * i);
+    }
+#endif
+
+    for (; i < n; i++) {
+        memcpy(state, sha256_iv, sizeof(state));
+        blocks_impl(state, in + 64 * i, 1);
+        if (blocks_impl == sha256_blocks_portable) sha256_block_kw(state, sha256d64_pad_kw); // the sha instructions expand the schedule for free, plain c does not
+        else blocks_impl(state, pad, 1);
+        for (j = 0; j < 8; j++) {
+            block[4 * j] = state[j] >> 24;
+            block[4 * j + 1] = state[j] >> 16;
+            block[4 * j + 2] = state[j] >> 8;
+            block[4 * j + 3] = state[j];
+        }
+        memcpy(state, sha256_iv, sizeof(state));
+        blocks_impl(state, block, 1);
+        for (j = 0; j < 8; j++) {
+            out[32 * i + 4 * j] = state[j] >> 24;
+            out[32 * i + 4 * j + 1] = state[j] >> 16;
+            out[32 * i + 4 * j + 2] = state[j] >> 8;
+            out[32 * i + 4 * j + 3] = state[j];
+        }
+    }
+}
+
+void sha256d(const uint8_t *message, size_t size, uint8_t *digest) // digest = sha256(sha256(message)), the outer hash is a single block with constant padding
+{
+    uint32_t state[8];
+    uint8_t block[64];
+    size_t j;
+
+    sha256(message, size, block);
+    memset(block + 32, 0, 32);
+    block[32] = 0x80;
+    block[62] = 0x01; // 256 bits
+    memcpy(state, sha256_iv, sizeof(state));
+    sha256_blocks(state, block, 1);
+    for (j = 0; j < 8; j++) {
+        digest[4 * j] = state[j] >> 24;
+        digest[4 * j + 1] = state[j] >> 16;
+        digest[4 * j + 2] = state[j] >> 8;
+        digest[4 * j + 3] = state[j];
+    }
+}
+
 /* SHA512 */
 
 typedef struct {
@@ -378,6 +1120,35 @@ typedef struct {
     size_t len;
 } SHA512_CTX;
 
+#define SHA512_BACKEND_AUTO 0 // fastest backend the cpu supports
+#define SHA512_BACKEND_PORTABLE 1
+#define SHA512_BACKEND_NI 2
+
+#define SHA512_ROUND(a, b, c, d, e, f, g, h, i, j) \
+    if (i) w[j] += sha512_f4(w[((j) + 14) & 15]) + w[((j) + 9) & 15] + sha512_f3(w[((j) + 1) & 15]); \
+    t1 = h + sha512_f2(e) + ch(e, f, g) + sha512_k[(i) + (j)] + w[j]; \
+    d += t1; \
+    h = t1 + sha512_f1(a) + maj(a, b, c)
+#define SHA512_ROUNDS16(i) /* the eight working variables trade roles instead of being moved */ \
+    SHA512_ROUND(a, b, c, d, e, f, g, h, i, 0); \
+    SHA512_ROUND(h, a, b, c, d, e, f, g, i, 1); \
+    SHA512_ROUND(g, h, a, b, c, d, e, f, i, 2); \
+    SHA512_ROUND(f, g, h, a, b, c, d, e, i, 3); \
+    SHA512_ROUND(e, f, g, h, a, b, c, d, i, 4); \
+    SHA512_ROUND(d, e, f, g, h, a, b, c, i, 5); \
+    SHA512_ROUND(c, d, e, f, g, h, a, b, i, 6); \
+    SHA512_ROUND(b, c, d, e, f, g, h, a, i, 7); \
+    SHA512_ROUND(a, b, c, d, e, f, g, h, i, 8); \
+    SHA512_ROUND(h, a, b, c, d, e, f, g, i, 9); \
+    SHA512_ROUND(g, h, a, b, c, d, e, f, i, 10); \
+    SHA512_ROUND(f, g, h, a, b, c, d, e, i, 11); \
+    SHA512_ROUND(e, f, g, h, a, b, c, d, i, 12); \
+    SHA512_ROUND(d, e, f, g, h, a, b, c, i, 13); \
+    SHA512_ROUND(c, d, e, f, g, h, a, b, i, 14); \
+    SHA512_ROUND(b, c, d, e, f, g, h, a, i, 15)
+
+void (*HASH_ATOMIC sha512_blocks_impl)(uint64_t *, const uint8_t *, size_t) = NULL; // compression backend, picked by sha512_set_backend on first use, atomic like sha256_blocks_impl
+
 uint64_t rotr64(uint64_t, int);
 uint64_t rotl64(uint64_t, int);
 uint64_t shfr64(uint64_t, int);
@@ -387,7 +1158,14 @@ uint64_t sha512_f1(uint64_t);
 uint64_t sha512_f2(uint64_t);
 uint64_t sha512_f3(uint64_t);
 uint64_t sha512_f4(uint64_t);
-void sha512_transf(SHA512_CTX *, const uint8_t *, uint32_t);
+void sha512_block(uint64_t *, const uint8_t *);
+void sha512_blocks_portable(uint64_t *, const uint8_t *, size_t);
+#if SHA512_NI
+void sha512_blocks_ni(uint64_t *, const uint8_t *, size_t);
+#endif
+int32_t sha512_backend_supported(int32_t);
+int32_t sha512_set_backend(int32_t);
+void sha512_blocks(uint64_t *, const uint8_t *, size_t);
 void sha512_init(SHA512_CTX *);
 void sha512_update(SHA512_CTX *, const uint8_t *, size_t);
 void sha512_finalize(SHA512_CTX *, uint8_t *);
@@ -460,43 +1238,141 @@ uint64_t sha512_f4(uint64_t x)
     return rotr64(x, 19) ^ rotr64(x, 61) ^ shfr64(x, 6);
 }
 
-void sha512_transf(SHA512_CTX *ctx, const uint8_t *message, uint32_t block_nb)
+void sha512_block(uint64_t *state, const uint8_t *block) // compress one 128 byte block into state, the schedule kept as a rolling 16 word window
 {
-    int i, j, pos;
-    uint64_t w[80], wv[8], t1, t2;
+    int j;
+    uint64_t a, b, c, d, e, f, g, h, w[16], t1;
+
+    for (j = 0; j < 16; j++) {
+        w[j] = ((uint64_t)block[8 * j] << 56) | ((uint64_t)block[8 * j + 1] << 48) | ((uint64_t)block[8 * j + 2] << 40) | ((uint64_t)block[8 * j + 3] << 32) |
+               ((uint64_t)block[8 * j + 4] << 24) | ((uint64_t)block[8 * j + 5] << 16) | ((uint64_t)block[8 * j + 6] << 8) | (uint64_t)block[8 * j + 7];
+    }
 
-    for (i = 0; i < block_nb; i++) {
+    a = state[0];
+    b = state[1];
+    c = state[2];
+    d = state[3];
+    e = state[4];
+    f = state[5];
+    g = state[6];
+    h = state[7];
+
+    SHA512_ROUNDS16(0); // all 80 rounds unrolled, the schedule words stay in registers
+    SHA512_ROUNDS16(16);
+    SHA512_ROUNDS16(32);
+    SHA512_ROUNDS16(48);
+    SHA512_ROUNDS16(64);
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
 
-        for (j = 0; j < 16; j++) {
-            pos = (i * 128) + (j * 8);
-            w[j] = ((uint64_t)(message[pos]) << 56) + ((uint64_t)(message[pos + 1]) << 48) + ((uint64_t)(message[pos + 2]) << 40) + ((uint64_t)(message[pos + 3]) << 32) + ((uint64_t)(message[pos + 4]) << 24) + ((uint64_t)(message[pos + 5]) << 16) + ((uint64_t)(message[pos + 6]) << 8) + (uint64_t)(message[pos + 7]);
-        }
+void sha512_blocks_portable(uint64_t *state, const uint8_t *blocks, size_t n) // compress n consecutive 128 byte blocks into state in plain c
+{
+    while (n--) {
+        sha512_block(state, blocks);
+        blocks += 128;
+    }
+}
 
-        for (j = 16; j < 80; j++) {
-            w[j] = sha512_f4(w[j -  2]) + w[j -  7] + sha512_f3(w[j - 15]) + w[j - 16];
+#if SHA512_NI
+__attribute__((target("sha512,avx2")))
+void sha512_blocks_ni(uint64_t *state, const uint8_t *blocks, size_t n) // compress n blocks with the x86 sha512 extensions, 4 rounds per pair of vsha512rnds2
+{
+    __m256i state0, state1, abef, cdgh, msg, t, w[4];
+    const __m256i mask = _mm256_set_epi64x(0x08090a0b0c0d0e0fULL, 0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL, 0x0001020304050607ULL); // big endian words
+    size_t g;
+
+    t = _mm256_loadu_si256((const __m256i *)&state[0]); // abcd
+    state1 = _mm256_loadu_si256((const __m256i *)&state[4]); // efgh
+    state0 = _mm256_shuffle_epi32(_mm256_permute2x128_si256(state1, t, 0x20), 0x4E); // the instructions want the state as abef and cdgh, highest word first
+    state1 = _mm256_shuffle_epi32(_mm256_permute2x128_si256(state1, t, 0x31), 0x4E);
+
+    while (n--) {
+        abef = state0;
+        cdgh = state1;
+        for (g = 0; g < 20; g++) { // w[g & 3] holds message words 4g..4g+3
+            if (g < 4) {
+                w[g] = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(blocks + 32 * g)), mask);
+            } else {
+                t = _mm256_sha512msg1_epi64(w[g & 3], _mm256_castsi256_si128(w[(g + 1) & 3]));
+                t = _mm256_add_epi64(t, _mm256_permute4x64_epi64(_mm256_blend_epi32(w[(g + 2) & 3], w[(g + 3) & 3], 0x03), 0x39)); // words 4g-7..4g-4
+                w[g & 3] = _mm256_sha512msg2_epi64(t, w[(g + 3) & 3]);
+            }
+            msg = _mm256_add_epi64(w[g & 3], _mm256_loadu_si256((const __m256i *)&sha512_k[4 * g]));
+            state1 = _mm256_sha512rnds2_epi64(state1, state0, _mm256_castsi256_si128(msg));
+            state0 = _mm256_sha512rnds2_epi64(state0, state1, _mm256_extracti128_si256(msg, 1));
         }
+        state0 = _mm256_add_epi64(state0, abef);
+        state1 = _mm256_add_epi64(state1, cdgh);
+        blocks += 128;
+    }
 
-        for (j = 0; j < 8; j++) {
-            wv[j] = ctx->state[j];
-        }
+    t = _mm256_shuffle_epi32(state0, 0x4E); // efab
+    state1 = _mm256_shuffle_epi32(state1, 0x4E); // ghcd
+    _mm256_storeu_si256((__m256i *)&state[0], _mm256_permute2x128_si256(t, state1, 0x31));
+    _mm256_storeu_si256((__m256i *)&state[4], _mm256_permute2x128_si256(t, state1, 0x20));
+}
+#endif
 
-        for (j = 0; j < 80; j++) {
-            t1 = wv[7] + sha512_f2(wv[4]) + ch(wv[4], wv[5], wv[6]) + sha512_k[j] + w[j];
-            t2 = sha512_f1(wv[0]) + maj(wv[0], wv[1], wv[2]);
-            wv[7] = wv[6];
-            wv[6] = wv[5];
-            wv[5] = wv[4];
-            wv[4] = wv[3] + t1;
-            wv[3] = wv[2];
-            wv[2] = wv[1];
-            wv[1] = wv[0];
-            wv[0] = t1 + t2;
-        }
+int32_t sha512_backend_supported(int32_t backend) // return 1 if this build and cpu can run the backend, return 0 otherwise
+{
+#if SHA512_NI
+    uint32_t eax, ebx, ecx, edx;
+#endif
 
-        for (j = 0; j < 8; j++) {
-            ctx->state[j] += wv[j];
-        }
+    switch (backend) {
+        case SHA512_BACKEND_AUTO:
+        case SHA512_BACKEND_PORTABLE:
+            return 1;
+#if SHA512_NI
+        case SHA512_BACKEND_NI:
+            if (!__builtin_cpu_supports("avx2")) return 0;
+            if (!__get_cpuid_count(7, 1, &eax, &ebx, &ecx, &edx)) return 0;
+            return eax & 1; // sha512
+#endif
+        default:
+            return 0;
+    }
+}
+
+int32_t sha512_set_backend(int32_t backend) // select the compression backend, SHA512_BACKEND_AUTO picks the fastest supported one and the others force one for testing, return 0 and keep the current one if it is not supported
+{
+    if (!sha512_backend_supported(backend)) return 0;
+
+    if (backend == SHA512_BACKEND_AUTO) {
+        backend = SHA512_BACKEND_PORTABLE;
+        if (sha512_backend_supported(SHA512_BACKEND_NI)) backend = SHA512_BACKEND_NI;
+    }
+
+    switch (backend) {
+#if SHA512_NI
+        case SHA512_BACKEND_NI:
+            sha512_blocks_impl = sha512_blocks_ni;
+            break;
+#endif
+        default:
+            sha512_blocks_impl = sha512_blocks_portable;
+            break;
+    }
+    return 1;
+}
+
+void sha512_blocks(uint64_t *state, const uint8_t *blocks, size_t n) // compress n consecutive 128 byte blocks into state with the selected backend
+{
+    void (*impl)(uint64_t *, const uint8_t *, size_t) = sha512_blocks_impl;
+
+    if (!impl) {
+        sha512_set_backend(SHA512_BACKEND_AUTO);
+        impl = sha512_blocks_impl;
     }
+    impl(state, blocks, n);
 }
 
 void sha512_init(SHA512_CTX *ctx)
@@ -530,8 +1406,8 @@ void sha512_update(SHA512_CTX *ctx, const uint8_t *message, size_t len)
 
     shifted_message = message + rem_len;
 
-    sha512_transf(ctx, ctx->block, 1);
-    sha512_transf(ctx, shifted_message, block_nb);
+    sha512_blocks(ctx->state, ctx->block, 1);
+    sha512_blocks(ctx->state, shifted_message, block_nb);
 
     rem_len = new_len % 128;
 
@@ -559,7 +1435,7 @@ void sha512_finalize(SHA512_CTX *ctx, uint8_t *digest)
     ctx->block[pm_len - 3] = (uint8_t)((len_b) >> 16);
     ctx->block[pm_len - 4] = (uint8_t)((len_b) >> 24);
 
-    sha512_transf(ctx, ctx->block, block_nb);
+    sha512_blocks(ctx->state, ctx->block, block_nb);
 
     for (i = 0 ; i < 8; i++) {
         digest[(i * 8) + 7] = (uint8_t)(ctx->state[i]);
@@ -667,21 +1543,86 @@ void hmac_sha512(const uint8_t *key, uint32_t key_size, const uint8_t *message,
 
 /* BNZ */
 
+#if defined(__SIZEOF_INT128__)
+typedef uint64_t bnz_limb_t; // 64 bit limbs with 128 bit intermediates
+typedef unsigned __int128 bnz_dlimb_t;
+#define BNZ_LIMB_BITS 64
+#else
+typedef uint32_t bnz_limb_t; // 32 bit limbs with 64 bit intermediates where __int128 is not available
+typedef uint64_t bnz_dlimb_t;
+#define BNZ_LIMB_BITS 32
+#endif
+
+#define BNZ_LIMB_BYTES (BNZ_LIMB_BITS / 8)
+#define BNZ_LIMB_MAX ((bnz_limb_t)-1)
+
+#ifndef BNZ_KARATSUBA_THRESHOLD
+#define BNZ_KARATSUBA_THRESHOLD 24 // limbs, shorter operands are multiplied by schoolbook, crossover measured on x86-64 with 64 bit limbs
+#endif
+#ifndef BNZ_TOOM3_THRESHOLD
+#define BNZ_TOOM3_THRESHOLD 256 // limbs, balanced operands of this size and above are multiplied by toom-3
+#endif
+#ifndef BNZ_STACK_LIMBS
+#define BNZ_STACK_LIMBS 64 // limbs, products whose output aliases an operand are formed on the stack up to this size
+#endif
+
 typedef struct {
     size_t sign;
     size_t size;
-    uint8_t *digits;
+    size_t alloc; // limbs allocated, size <= alloc
+    size_t ext; // limbs are borrowed from a scratch arena or the stack, never reallocated or freed
+    bnz_limb_t *limbs;
 } bnz_t;
 
+typedef struct {
+    bnz_limb_t *base; // arena memory
+    size_t cap; // limbs in base
+    size_t top; // limbs handed out, released by rewinding to an earlier mark
+    size_t peak; // high water mark of top
+    size_t overflows; // requests that did not fit while the arena was in use
+} bnz_scratch_t;
+
+#ifndef BNZ_SCRATCH_LIMBS
+#define BNZ_SCRATCH_LIMBS 4096 // limbs, initial size of the per thread arena, it grows when idle
+#endif
+
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define BNZ_THREAD_LOCAL _Thread_local
+#else
+#define BNZ_THREAD_LOCAL
+#endif
+
+BNZ_THREAD_LOCAL size_t bnz_heap_allocs = 0; // heap (re)allocations made for bnz limbs and scratch, flat once the hot paths are warm
+BNZ_THREAD_LOCAL bnz_scratch_t bnz_scratch_local = {NULL, 0, 0, 0, 0}; // per thread default arena, a thread that used it must call bnz_scratch_thread_exit before it ends or its memory leaks
+BNZ_THREAD_LOCAL bnz_scratch_t *bnz_scratch_cur = NULL;
+
+typedef struct {
+    bnz_t m; // odd modulus, n limbs
+    bnz_t r2; // R^2 mod m with R = B^n, n limbs
+    bnz_limb_t m_inv; // -m^-1 mod B
+    bnz_limb_t *t; // 2n limbs of product scratch
+    size_t ext; // t is borrowed from a scratch arena
+} bnz_mont_ctx;
+
 void bnz_init(bnz_t *);
 void bnz_resize(bnz_t *, size_t, int32_t);
+void bnz_reserve(bnz_t *, size_t);
 void bnz_align(bnz_t *, bnz_t *);
-void bnz_reverse_digits(bnz_t *);
 void bnz_shift_r(bnz_t *, uint32_t);
 void bnz_trim(bnz_t *);
 void bnz_print(bnz_t *, int32_t, const char *);
 void bnz_free(bnz_t *);
 
+int32_t bnz_scratch_init(bnz_scratch_t *, size_t);
+void bnz_scratch_free(bnz_scratch_t *);
+bnz_scratch_t *bnz_scratch(void);
+bnz_scratch_t *bnz_scratch_use(bnz_scratch_t *);
+void bnz_scratch_thread_exit(void);
+size_t bnz_scratch_mark(bnz_scratch_t *);
+void bnz_scratch_rewind(bnz_scratch_t *, size_t);
+bnz_limb_t *bnz_scratch_limbs(bnz_scratch_t *, size_t);
+void bnz_scratch_bnz(bnz_scratch_t *, bnz_t *, size_t);
+
 uint8_t get_digit(const uint8_t *, size_t, uint8_t);
 uint8_t get_val_from_char_d(uint8_t);
 uint8_t get_val_from_char_16(uint8_t);
@@ -689,61 +1630,134 @@ uint8_t get_val_from_char_58(uint8_t);
 uint8_t get_val_from_char_64(uint8_t);
 uint8_t *get_base_n_str(bnz_t *, uint32_t, const char *);
 
+size_t bnz_byte_size(bnz_t *);
+void bnz_get_bytes(bnz_t *, uint8_t *, size_t);
+void get_bytes_limb_arr(bnz_limb_t *, size_t, uint8_t *, size_t);
+
 void bnz_set_i32(bnz_t *, int32_t);
 void bnz_set_ui32(bnz_t *, uint32_t);
 void bnz_set_str(bnz_t *, const uint8_t *, uint8_t);
+void bnz_set_bytes(bnz_t *, const uint8_t *, size_t);
+void set_bytes_limb_arr(bnz_limb_t *, size_t, const uint8_t *, size_t);
+void bnz_set_limbs(bnz_t *, bnz_limb_t *, size_t);
 void bnz_set_bnz(bnz_t *, bnz_t *);
+void bnz_view_i32(bnz_t *, bnz_limb_t *, int32_t);
+
+int32_t cmp_limb_arr(bnz_limb_t *, bnz_limb_t *, size_t);
+bnz_limb_t add_limb_arr(bnz_limb_t *, bnz_limb_t *, bnz_limb_t *, size_t);
+bnz_limb_t sub_limb_arr(bnz_limb_t *, bnz_limb_t *, bnz_limb_t *, size_t);
+bnz_limb_t add_1_limb_arr(bnz_limb_t *, bnz_limb_t *, size_t, bnz_limb_t);
+bnz_limb_t sub_1_limb_arr(bnz_limb_t *, bnz_limb_t *, size_t, bnz_limb_t);
+void add_at_limb_arr(bnz_limb_t *, size_t, size_t, bnz_limb_t *, size_t);
+void neg_limb_arr(bnz_limb_t *, size_t);
+void shift_r1_signed_limb_arr(bnz_limb_t *, size_t);
+void divexact_3_limb_arr(bnz_limb_t *, size_t);
+bnz_limb_t mul_add_limb_arr(bnz_limb_t *, size_t, bnz_limb_t, bnz_limb_t);
+void mul_basecase_limb_arr(bnz_limb_t *, bnz_limb_t *, size_t, bnz_limb_t *, size_t);
+void mul_limb_arr(bnz_limb_t *, bnz_limb_t *, size_t, bnz_limb_t *, size_t);
+size_t mul_scratch_size(size_t, size_t);
+void mul_n_limb_arr(bnz_limb_t *, bnz_limb_t *, bnz_limb_t *, size_t, bnz_limb_t *);
+void mul_unbalanced_limb_arr(bnz_limb_t *, bnz_limb_t *, size_t, bnz_limb_t *, size_t, bnz_limb_t *);
+void mul_karatsuba_limb_arr(bnz_limb_t *, bnz_limb_t *, bnz_limb_t *, size_t, bnz_limb_t *);
+void mul_toom3_limb_arr(bnz_limb_t *, bnz_limb_t *, bnz_limb_t *, size_t, bnz_limb_t *);
+int32_t toom3_eval_limb_arr(bnz_limb_t *, bnz_limb_t *, size_t, size_t, int32_t);
+void sqr_basecase_limb_arr(bnz_limb_t *, bnz_limb_t *, size_t);
+void sqr_limb_arr(bnz_limb_t *, bnz_limb_t *, size_t);
+void sqr_n_limb_arr(bnz_limb_t *, bnz_limb_t *, size_t, bnz_limb_t *);
+void sqr_karatsuba_limb_arr(bnz_limb_t *, bnz_limb_t *, size_t, bnz_limb_t *);
+bnz_limb_t reciprocal_limb(bnz_limb_t);
+bnz_limb_t reciprocal_2_limb(bnz_limb_t, bnz_limb_t);
+bnz_limb_t div_2by1_limb(bnz_limb_t *, bnz_limb_t, bnz_limb_t, bnz_limb_t, bnz_limb_t);
+bnz_limb_t div_3by2_limb(bnz_limb_t *, bnz_limb_t *, bnz_limb_t, bnz_limb_t, bnz_limb_t, bnz_limb_t, bnz_limb_t, bnz_limb_t);
+bnz_limb_t submul_1_limb_arr(bnz_limb_t *, bnz_limb_t *, size_t, bnz_limb_t);
+bnz_limb_t addmul_1_limb_arr(bnz_limb_t *, bnz_limb_t *, size_t, bnz_limb_t);
+bnz_limb_t div_limb_arr(bnz_limb_t *, size_t, bnz_limb_t);
+void divmod_limb_arr(bnz_limb_t *, bnz_limb_t *, bnz_limb_t *, size_t, bnz_limb_t *, size_t, bnz_limb_t *, bnz_limb_t *);
+void mont_redc_limb_arr(bnz_limb_t *, bnz_limb_t *, bnz_limb_t *, size_t, bnz_limb_t);
+void barrett_limb_arr(bnz_limb_t *, bnz_limb_t *, bnz_limb_t *, size_t, bnz_limb_t *, size_t, bnz_limb_t *);
 
-int32_t cmp_uint8_arr(uint8_t *, uint8_t *, size_t);
 int32_t bnz_cmp_i32(bnz_t *, int32_t);
 int32_t bnz_cmp_bnz(bnz_t *, bnz_t *);
 int32_t bnz_is_zero(bnz_t *);
 int32_t bnz_bit_set(bnz_t *, uint32_t);
-
-void bnz_concatenate_ui8(bnz_t *, bnz_t *, uint8_t, size_t);
-void bnz_concatenate_bnz(bnz_t *, bnz_t *, bnz_t *, size_t);
+size_t bnz_bit_length(bnz_t *);
 
 void bnz_add_i32(bnz_t *, bnz_t *, int32_t);
 void bnz_add_bnz(bnz_t *, bnz_t *, bnz_t *);
+void bnz_add_signed(bnz_t *, bnz_t *, bnz_t *, size_t);
 void bnz_addition(bnz_t *, bnz_t *, bnz_t *);
 void bnz_subtract_bnz(bnz_t *, bnz_t *, bnz_t *);
 void bnz_subtraction(bnz_t *, bnz_t *, bnz_t *);
+void bnz_add_inplace(bnz_t *, bnz_t *);
+void bnz_sub_inplace(bnz_t *, bnz_t *);
+void bnz_addmul_limb(bnz_t *, bnz_t *, bnz_limb_t, size_t, size_t);
+void bnz_addmul_ui32(bnz_t *, bnz_t *, uint32_t);
+void bnz_submul_ui32(bnz_t *, bnz_t *, uint32_t);
+void bnz_addmul(bnz_t *, bnz_t *, bnz_t *);
+void bnz_submul(bnz_t *, bnz_t *, bnz_t *);
 void bnz_multiply_i32(bnz_t *, bnz_t *, int32_t);
 void bnz_multiply_bnz(bnz_t *, bnz_t *, bnz_t *);
+void bnz_square(bnz_t *, bnz_t *);
 void bnz_division_signs(bnz_t *, bnz_t *, bnz_t *, bnz_t *);
 void bnz_divide_bnz(bnz_t *, bnz_t *, bnz_t *, bnz_t *);
 void bnz_division(bnz_t *, bnz_t *, bnz_t *, bnz_t *);
 void bnz_mod_bnz(bnz_t *, bnz_t *, bnz_t *);
 
+uint32_t bnz_pow_window(size_t);
+uint32_t bnz_pow_window_bits(bnz_t *, size_t, uint32_t, uint32_t *);
 void bnz_mod_pow(bnz_t *, bnz_t *, bnz_t *, bnz_t *);
 void bnz_modular_multiplicative_inverse(bnz_t *, bnz_t *, bnz_t *);
 
+int32_t bnz_mont_init(bnz_mont_ctx *, bnz_t *);
+int32_t bnz_mont_init_scratch(bnz_mont_ctx *, bnz_t *, bnz_scratch_t *);
+void bnz_mont_free(bnz_mont_ctx *);
+void bnz_mont_mul(bnz_t *, bnz_t *, bnz_t *, bnz_mont_ctx *);
+void bnz_mont_sqr(bnz_t *, bnz_t *, bnz_mont_ctx *);
+void bnz_to_mont(bnz_t *, bnz_t *, bnz_mont_ctx *);
+void bnz_from_mont(bnz_t *, bnz_t *, bnz_mont_ctx *);
+void bnz_mod_pow_mont(bnz_t *, bnz_t *, bnz_t *, bnz_mont_ctx *);
+
 void bnz_init(bnz_t *a) // initiate bnz_t components
 {
     a->sign = 0;
     a->size = 0;
-    a->digits = NULL;
+    a->alloc = 0;
+    a->ext = 0;
+    a->limbs = NULL;
 }
 
-void bnz_resize(bnz_t *a, size_t new_size, int32_t preserve) // increase or decrease number of bytes in a->digits, zeroing added bytes, and preserving or zeroing existing bytes
+void bnz_resize(bnz_t *a, size_t new_size, int32_t preserve) // increase or decrease number of limbs in a->limbs, zeroing added limbs, and preserving or zeroing existing limbs, reallocating only when the capacity grows
 {
-    uint8_t *tmp = NULL;
     size_t prev_size = a->size;
     if (new_size < 1) new_size = 1;
-    tmp = realloc(a->digits, new_size);
-    if (tmp) {
-        if (preserve) {
-            if (new_size > prev_size) memset(tmp + prev_size, 0, new_size - prev_size); // zero new bytes
-        } else {
-            a->sign = 0;
-            memset(tmp, 0, new_size); //zero all bytes
-        }
-        a->digits = tmp;
-        a->size = new_size;
+    bnz_reserve(a, new_size);
+    if (new_size > a->alloc) return; // out of memory, a is unchanged
+    if (preserve) {
+        if (new_size > prev_size) memset(a->limbs + prev_size, 0, (new_size - prev_size) * sizeof(bnz_limb_t)); // zero new limbs
+    } else {
+        a->sign = 0;
+        memset(a->limbs, 0, new_size * sizeof(bnz_limb_t)); //zero all limbs
     }
+    a->size = new_size;
 }
 
-void bnz_align(bnz_t *a, bnz_t *b) // resize a->digits or b->digits to match the byte count of the longer of a and b
+void bnz_reserve(bnz_t *a, size_t n) // grow the capacity of a->limbs to at least n limbs, keeping the value and size of a, borrowed limbs move to the heap
+{
+    bnz_limb_t *tmp = NULL;
+    if (n <= a->alloc) return;
+    if (a->ext) {
+        if (!(tmp = malloc(n * sizeof(bnz_limb_t)))) return;
+        memcpy(tmp, a->limbs, a->size * sizeof(bnz_limb_t));
+        a->ext = 0;
+    } else if (!(tmp = realloc(a->limbs, n * sizeof(bnz_limb_t)))) {
+        return;
+    }
+    bnz_heap_allocs++;
+    a->limbs = tmp;
+    a->alloc = n;
+}
+
+void bnz_align(bnz_t *a, bnz_t *b) // resize a->limbs or b->limbs to match the limb count of the longer of a and b
 {
     bnz_trim(a);
     bnz_trim(b);
@@ -754,64 +1768,45 @@ void bnz_align(bnz_t *a, bnz_t *b) // resize a->digits or b->digits to match the
     }
 }
 
-void bnz_reverse_digits(bnz_t *a) // reverse the order of the bytes in a->digits
-{
-    uint8_t tmp;
-    size_t i = 0, j = a->size - 1;
-    while (i < j) {
-        tmp = a->digits[i];
-        a->digits[i] = a->digits[j];
-        a->digits[j] = tmp;
-        i++;
-        j--;
-    }
-}
-
-void bnz_shift_r(bnz_t *a, uint32_t sh) // shift the bits in a->digits to the right by sh bits, adding 0 value bits to msb end
+void bnz_shift_r(bnz_t *a, uint32_t sh) // shift the bits in a->limbs to the right by sh bits, adding 0 value bits to msb end
 {
-    uint8_t msk = 255 >> (8 - sh);
-    size_t i, orig_size = a->size;
-    if (sh < 1 || sh > 7) return;
-    bnz_resize(a, orig_size + 1, 1);
-    bnz_reverse_digits(a);
-    for (i = a->size - 1; i > 0; i--) {
-        a->digits[i] = (a->digits[i - 1] & msk) << (8 - sh) | a->digits[i] >> sh;
+    size_t i;
+    if (sh < 1 || sh >= BNZ_LIMB_BITS) return;
+    for (i = 0; i + 1 < a->size; i++) {
+        a->limbs[i] = (a->limbs[i] >> sh) | (a->limbs[i + 1] << (BNZ_LIMB_BITS - sh));
     }
-    bnz_reverse_digits(a);
-    bnz_resize(a, orig_size, 1);
+    a->limbs[a->size - 1] >>= sh;
 }
 
-void bnz_trim(bnz_t *a) // trim 0 value bytes from msb end of a->digits
+void bnz_trim(bnz_t *a) // trim 0 value limbs from msb end of a->limbs, and clear the sign of 0
 {
     size_t new_size = a->size;
-    while (a->digits[new_size - 1] == 0 && new_size >= 0) {
+    while (new_size > 1 && a->limbs[new_size - 1] == 0) {
         new_size--;
     }
     bnz_resize(a, new_size, 1);
+    if (a->size == 1 && a->limbs[0] == 0) a->sign = 0;
 }
 
 void bnz_print(bnz_t *a, int32_t base, const char *txt) // print a in a given base, preceded by optional string 
 {
-    uint8_t *str = NULL;
-    size_t i, j;
-    bnz_t tmp;
+    uint8_t *str = NULL, *bytes = NULL;
+    size_t i, j, len = bnz_byte_size(a);
 
-    bnz_init(&tmp);
-
-    bnz_set_bnz(&tmp, a);
+    if (!(bytes = init_uint8_array(len))) return;
 
-    bnz_reverse_digits(&tmp);
+    bnz_get_bytes(a, bytes, len); // big endian bytes of |a|
 
     switch (base) {
         case -2: // binary with spaces between bytes
             printf("%s", txt);
-            if (bnz_is_zero(&tmp)) {
+            if (bnz_is_zero(a)) {
                 printf("0\n");
             } else {
-                if (tmp.sign) printf("-");
-                for (i = 0; i < tmp.size; i++) { // traverse bytes
+                if (a->sign) printf("-");
+                for (i = 0; i < len; i++) { // traverse bytes
                     for (j = 0; j < 8; j++) { // divide each byte into 8 bits
-                        printf("%d", (tmp.digits[i] >> (7 - j)) & 1);
+                        printf("%d", (bytes[i] >> (7 - j)) & 1);
                     }
                     printf(" "); // add space between each byte
                 }
@@ -820,13 +1815,13 @@ void bnz_print(bnz_t *a, int32_t base, const char *txt) // print a in a given ba
             break;
         case 2: // binary
             printf("%s", txt);
-            if (bnz_is_zero(&tmp)) {
+            if (bnz_is_zero(a)) {
                 printf("0\n");
             } else {
-                if (tmp.sign) printf("-");
-                for (i = 0; i < tmp.size; i++) { // traverse bytes
+                if (a->sign) printf("-");
+                for (i = 0; i < len; i++) { // traverse bytes
                     for (j = 0; j < 8; j++) { // divide each byte into 8 bits
-                        printf("%d", (tmp.digits[i] >> (7 - j)) & 1);
+                        printf("%d", (bytes[i] >> (7 - j)) & 1);
                     }
                 }
                 printf("\n");
@@ -834,97 +1829,186 @@ void bnz_print(bnz_t *a, int32_t base, const char *txt) // print a in a given ba
             break;
         case -16: // hex, upper case, without "0x" prefix, same as default for 0 to F
             printf("%s", txt);
-            if (bnz_is_zero(&tmp)) {
+            if (bnz_is_zero(a)) {
                 printf("0\n");
             } else {
-                if (!(str = get_base_n_str(&tmp, 16, "0123456789ABCDEF"))) return;
-                if (tmp.sign) printf("-");
+                if (!(str = get_base_n_str(a, 16, "0123456789ABCDEF"))) break;
+                if (a->sign) printf("-");
                 printf("%s\n", str);
             }
             break;
         case 16: // hex, lower case with "0x" prefix
             printf("%s", txt);
-            if (bnz_is_zero(&tmp)) {
+            if (bnz_is_zero(a)) {
                 printf("0x0\n");
             } else {
-                if (tmp.sign) printf("-");
+                if (a->sign) printf("-");
                 printf("0x");
-                for (i = 0; i < tmp.size; i++) {
-                    printf("%02x", tmp.digits[i]);
+                for (i = 0; i < len; i++) {
+                    printf("%02x", bytes[i]);
                 }
                 printf("\n");
             }
             break;
         case -58: // standard base 58
             printf("%s", txt);
-            if (bnz_is_zero(&tmp)) {
+            if (bnz_is_zero(a)) {
                 printf("0\n");
             } else {
-                if (!(str = get_base_n_str(&tmp, 58, "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz_"))) return;
-                if (tmp.sign) printf("-");
+                if (!(str = get_base_n_str(a, 58, "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz_"))) break;
+                if (a->sign) printf("-");
                 printf("%s\n", str);
             }
             break;
         case 58: // bitcoin base 58
             printf("%s", txt);
-            if (bnz_is_zero(&tmp)) {
+            if (bnz_is_zero(a)) {
                 printf("1\n");
             } else {
-                if (!(str = get_base_n_str(&tmp, 58, "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz"))) return;
-                if (tmp.sign) printf("-");
+                if (!(str = get_base_n_str(a, 58, "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz"))) break;
+                if (a->sign) printf("-");
                 printf("%s\n", str);
             }
             break;
         case 64:
             printf("%s", txt);
-            if (bnz_is_zero(&tmp)) {
+            if (bnz_is_zero(a)) {
                 printf("A\n");
             } else {
-                if (!(str = get_base_n_str(&tmp, 64, "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"))) return;
-                if (tmp.sign) printf("-");
+                if (!(str = get_base_n_str(a, 64, "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"))) break;
+                if (a->sign) printf("-");
                 printf("%s\n", str);
             }
             break;
         case 256: // individual byte values, base 10, separated by ", "
             printf("%s", txt);
-            if (bnz_is_zero(&tmp)) {
+            if (bnz_is_zero(a)) {
                 printf("0\n");
             } else {
-                if (tmp.sign) printf("-");
-                printf("%d", tmp.digits[0]);
-                for (i = 1; i < tmp.size; i++) {
-                    printf(", %d", tmp.digits[i]);
+                if (a->sign) printf("-");
+                printf("%d", bytes[0]);
+                for (i = 1; i < len; i++) {
+                    printf(", %d", bytes[i]);
                 }
                 printf("\n");
             }
             break;
         default: // default for 2 to 63
             printf("%s", txt);
-            if (bnz_is_zero(&tmp)) {
+            if (bnz_is_zero(a)) {
                 printf("0\n");
             } else {
                 if (base >= 2 && base <= 63) {
-                    if (!(str = get_base_n_str(&tmp, base, "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz_"))) return;
-                    if (tmp.sign) printf("-");
+                    if (!(str = get_base_n_str(a, base, "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz_"))) break;
+                    if (a->sign) printf("-");
                     printf("%s\n", str);
                 }
             }
             break;
     }
 
-    bnz_free(&tmp);
+    free(bytes);
     free(str);
 }
 
-void bnz_free(bnz_t *a) // free bnz_t resources
+void bnz_free(bnz_t *a) // free bnz_t resources, borrowed limbs are left to their owner
 {
     a->sign = 0;
     a->size = 0;
-    free(a->digits);
-    a->digits = NULL;
+    a->alloc = 0;
+    if (!a->ext) free(a->limbs);
+    a->ext = 0;
+    a->limbs = NULL;
 }
 
-uint8_t get_digit(const uint8_t *str, size_t idx, uint8_t base) // return numerical value of char at index idx of str representing a number in the given base and in big endian order
+int32_t bnz_scratch_init(bnz_scratch_t *s, size_t n) // set up an arena of n limbs, return 0 if out of memory
+{
+    s->cap = 0;
+    s->top = 0;
+    s->peak = 0;
+    s->overflows = 0;
+    if (!(s->base = malloc(n * sizeof(bnz_limb_t)))) return 0;
+    bnz_heap_allocs++;
+    s->cap = n;
+    return 1;
+}
+
+void bnz_scratch_free(bnz_scratch_t *s) // free arena memory
+{
+    free(s->base);
+    s->base = NULL;
+    s->cap = 0;
+    s->top = 0;
+}
+
+bnz_scratch_t *bnz_scratch(void) // return the arena for bnz temporaries on this thread, setting up the per thread default on first use
+{
+    if (bnz_scratch_cur) return bnz_scratch_cur;
+    if (!bnz_scratch_local.base) bnz_scratch_init(&bnz_scratch_local, BNZ_SCRATCH_LIMBS);
+    return bnz_scratch_cur = &bnz_scratch_local;
+}
+
+bnz_scratch_t *bnz_scratch_use(bnz_scratch_t *s) // pass a caller owned arena down to bnz temporaries on this thread, NULL restores the default, return the previous arena
+{
+    bnz_scratch_t *prev = bnz_scratch_cur;
+    bnz_scratch_cur = s;
+    return prev;
+}
+
+void bnz_scratch_thread_exit(void) // free the per thread default arena, for worker threads about to end, the main thread may leave it to process exit
+{
+    if (bnz_scratch_cur == &bnz_scratch_local) bnz_scratch_cur = NULL;
+    bnz_scratch_free(&bnz_scratch_local);
+}
+
+size_t bnz_scratch_mark(bnz_scratch_t *s) // return the current top of s, to rewind to at scope exit
+{
+    return s->top;
+}
+
+void bnz_scratch_rewind(bnz_scratch_t *s, size_t mark) // release everything carved from s since mark
+{
+    s->top = mark;
+}
+
+bnz_limb_t *bnz_scratch_limbs(bnz_scratch_t *s, size_t n) // carve n limbs from s, return NULL if they do not fit, an idle arena grows instead
+{
+    bnz_limb_t *tmp = NULL;
+    size_t cap;
+
+    if (s->top + n > s->cap) {
+        if (s->top) { // live carves pin the arena in place
+            s->overflows++;
+            return NULL;
+        }
+        cap = 2 * s->cap > n ? 2 * s->cap : n;
+        if (!(tmp = realloc(s->base, cap * sizeof(bnz_limb_t)))) {
+            s->overflows++;
+            return NULL;
+        }
+        bnz_heap_allocs++;
+        s->base = tmp;
+        s->cap = cap;
+    }
+
+    tmp = s->base + s->top;
+    s->top += n;
+    if (s->top > s->peak) s->peak = s->top;
+    return tmp;
+}
+
+void bnz_scratch_bnz(bnz_scratch_t *s, bnz_t *a, size_t n) // initiate a as 0 backed by n limbs of s, a falls back to the heap if s is full or a outgrows them, bnz_free is still required
+{
+    bnz_init(a);
+    if (n < 1) n = 1;
+    if (!(a->limbs = bnz_scratch_limbs(s, n))) return;
+    a->ext = 1;
+    a->alloc = n;
+    a->size = 1;
+    a->limbs[0] = 0;
+}
+
+uint8_t get_digit(const uint8_t *str, size_t idx, uint8_t base) // return numerical value of char at index idx of str representing a number in the given base and in big endian order
 {
     uint8_t dgt;
     switch (base) {
@@ -1596,85 +2680,168 @@ uint8_t get_val_from_char_64(uint8_t ch) /* look-up table for numberical value o
     }
 }
 
-uint8_t *get_base_n_str(bnz_t *a, uint32_t base, const char *alpha) // return a null terminated string representing a->digits in given base, big endian order
+uint8_t *get_base_n_str(bnz_t *a, uint32_t base, const char *alpha) // return a null terminated string representing |a| in given base, big endian order
 {
-    uint8_t *base_n_str = NULL, *base_n_str_trimmed = NULL;
-    uint32_t base_abs = base < 0 ? base * -1 : base;
-    size_t i, j, k, trim = 0, len = (a->size * log10((double)256)) / log10((double)base_abs) + 1;
-
-    if (!(base_n_str = init_uint8_array(len + 1))) return NULL;
+    uint8_t *base_n_str = NULL, ch;
+    bnz_limb_t *tmp = NULL, chunk_base = base, rem;
+    bnz_scratch_t *s = bnz_scratch();
+    size_t i, n = a->size, len = 0, chunk_len = 1, mark = bnz_scratch_mark(s);
+
+    while (chunk_base <= BNZ_LIMB_MAX / base) { // largest power of base that fits in one limb
+        chunk_base *= base;
+        chunk_len++;
+    }
 
-    for (i = 0; i < a->size; i++) {
-        k = a->digits[i];
-        for (j = len; j > 0; j--) {
-            k += (uint32_t)base_n_str[j - 1] * 256;
-            base_n_str[j - 1] = (uint8_t)(k % base_abs);
-            k /= base_abs;
+    if (!(base_n_str = init_uint8_array(n * BNZ_LIMB_BITS + chunk_len + 1))) return NULL;
+    if (!(tmp = bnz_scratch_limbs(s, n))) { // arena busy and full, take the heap
+        if (!(tmp = malloc(n * sizeof(bnz_limb_t)))) {
+            free(base_n_str);
+            return NULL;
         }
+        bnz_heap_allocs++;
+        s = NULL;
+    }
+    memcpy(tmp, a->limbs, n * sizeof(bnz_limb_t));
+
+    while (n > 0 && tmp[n - 1] == 0) n--;
+    while (n > 0) { // each limb division by chunk_base yields chunk_len digits, lsb end first
+        rem = div_limb_arr(tmp, n, chunk_base);
+        for (i = 0; i < chunk_len; i++) {
+            base_n_str[len++] = alpha[rem % base];
+            rem /= base;
+        }
+        while (n > 0 && tmp[n - 1] == 0) n--;
+    }
+
+    while (len > 1 && base_n_str[len - 1] == alpha[0]) len--; // trim leading zeros at msb end, 1 for base 58, A for base 64
+    if (len == 0) base_n_str[len++] = alpha[0];
+    base_n_str[len] = 0;
+
+    for (i = 0; i < len / 2; i++) { // convert to big endian order
+        ch = base_n_str[i];
+        base_n_str[i] = base_n_str[len - 1 - i];
+        base_n_str[len - 1 - i] = ch;
     }
 
-    while (alpha[base_n_str[trim]] == '0' || (base == 58 && alpha[base_n_str[trim]] == '1') || (base == 64 && alpha[base_n_str[trim]] == 'A')) { // trim leading zeros at msb end, 1 for base 58, A for base 64
-        trim++;
-        len--;
+    if (s) {
+        bnz_scratch_rewind(s, mark);
+    } else {
+        free(tmp);
     }
+    return base_n_str;
+}
+
+size_t bnz_byte_size(bnz_t *a) // return the number of bytes needed to hold |a|, minimum 1
+{
+    size_t n = a->size, len;
+    bnz_limb_t top;
+    while (n > 1 && a->limbs[n - 1] == 0) n--;
+    if (n == 0) return 1;
+    len = (n - 1) * BNZ_LIMB_BYTES;
+    top = a->limbs[n - 1];
+    do {
+        len++;
+        top >>= 8;
+    } while (top);
+    return len;
+}
 
-    if (!(base_n_str_trimmed = init_uint8_array(len + 1))) return NULL;
+void bnz_get_bytes(bnz_t *a, uint8_t *bytes, size_t len) // write the len least significant bytes of |a| to bytes in big endian order, padded with leading zeros
+{
+    get_bytes_limb_arr(a->limbs, a->size, bytes, len);
+}
 
+void get_bytes_limb_arr(bnz_limb_t *a, size_t n, uint8_t *bytes, size_t len) // write the len least significant bytes of an n limb array to bytes in big endian order, padded with leading zeros
+{
+    size_t i, limb;
     for (i = 0; i < len; i++) {
-        base_n_str_trimmed[i] = alpha[base_n_str[i + trim]];
+        limb = i / BNZ_LIMB_BYTES;
+        bytes[len - 1 - i] = limb < n ? (uint8_t)(a[limb] >> (8 * (i % BNZ_LIMB_BYTES))) : 0;
     }
-
-    free(base_n_str);
-    return base_n_str_trimmed;
 }
 
-void bnz_set_i32(bnz_t *a, int32_t b) // convert int32_t to bnz_t and invoke bnz_set_bnz
+void bnz_set_i32(bnz_t *a, int32_t b) // convert int32_t to bnz_t
 {
+    bnz_resize(a, 1, 0);
     if (b < 0) { // b is negative
         a->sign = 1; // sign == 1 for negative b,  0 for positive b
-        b *= -1; // multiply negative int32_t by -1 to de-complement bytes to |b|
+        a->limbs[0] = 0 - (uint32_t)b; // |b|, also valid for INT32_MIN
+    } else {
+        a->limbs[0] = (uint32_t)b;
     }
-    bnz_resize(a, 4, 0);
-    memcpy(a->digits, &b, 4);
-    bnz_trim(a);
 }
 
-void bnz_set_ui32(bnz_t *a, uint32_t b) // convert uint32_t to bnz_t and invoke bnz_set_bnz
+void bnz_set_ui32(bnz_t *a, uint32_t b) // convert uint32_t to bnz_t
 {
-    bnz_resize(a, 4, 0);
-    memcpy(a->digits, &b, 4);
-    bnz_trim(a);
+    bnz_resize(a, 1, 0);
+    a->limbs[0] = b;
 }
 
 void bnz_set_str(bnz_t *a, const uint8_t *str, uint8_t base) // set bnz_t to number represented by str with radix between 2 and 64, and with its digits in big endian order
 {
-    uint32_t d;
-    size_t i, j, len = (size_t)((double)strlen(str) * log(base)/log(256)) + 1, idx = 0;
-    bnz_resize(a, len, 0);
+    bnz_limb_t chunk, chunk_base;
+    size_t len = strlen(str), idx = 0;
+    bnz_resize(a, (len * 6) / BNZ_LIMB_BITS + 1, 0); // 6 bits per digit is enough for every radix up to 64
     if (str[0] == '-') { // if first symbol of str is "-", set sign to 1 and set starting index of digits to 1 
         a->sign = 1;
         idx = 1;
     }
-    for (i = idx; i < strlen(str); i++) {
-        d = get_digit(str, i, base);
-        for (j = len; j > 0; j--) {
-            d += a->digits[j - 1] * base;
-            a->digits[j - 1] = d & 255;
-            d >>= 8;
+    while (idx < len) {
+        chunk = 0;
+        chunk_base = 1;
+        while (idx < len && chunk_base <= BNZ_LIMB_MAX / base) { // gather as many digits as fit in one limb
+            chunk = chunk * base + get_digit(str, idx++, base);
+            chunk_base *= base;
         }
+        mul_add_limb_arr(a->limbs, a->size, chunk_base, chunk); // a = a * base^digits + chunk
+    }
+    bnz_trim(a);
+}
+
+void bnz_set_bytes(bnz_t *a, const uint8_t *bytes, size_t len) // set bnz_t to the unsigned number represented by len bytes in big endian order
+{
+    bnz_resize(a, (len + BNZ_LIMB_BYTES - 1) / BNZ_LIMB_BYTES, 0);
+    set_bytes_limb_arr(a->limbs, a->size, bytes, len);
+    bnz_trim(a);
+}
+
+void set_bytes_limb_arr(bnz_limb_t *a, size_t n, const uint8_t *bytes, size_t len) // set an n limb array to the number represented by len bytes in big endian order, bytes beyond n limbs are dropped from the msb end
+{
+    size_t i;
+    memset(a, 0, n * sizeof(bnz_limb_t));
+    for (i = 0; i < len && i / BNZ_LIMB_BYTES < n; i++) {
+        a[i / BNZ_LIMB_BYTES] |= (bnz_limb_t)bytes[len - 1 - i] << (8 * (i % BNZ_LIMB_BYTES));
     }
-    bnz_reverse_digits(a); // convert a->digits to lsb order
+}
+
+void bnz_set_limbs(bnz_t *a, bnz_limb_t *limbs, size_t n) // set bnz_t to the unsigned number held in an n limb array, least significant limb first
+{
+    bnz_resize(a, n, 0);
+    memcpy(a->limbs, limbs, n * sizeof(bnz_limb_t));
     bnz_trim(a);
 }
 
-void bnz_set_bnz(bnz_t *a, bnz_t *b) // set bnz-t equivalent to another bnz_t
+void bnz_set_bnz(bnz_t *a, bnz_t *b) // set bnz-t equivalent to another bnz_t, reusing the capacity of a
 {
-    bnz_resize(a, b->size, 0);
-    memcpy(a->digits, b->digits, b->size);
+    if (a == b) return;
+    bnz_reserve(a, b->size);
+    if (b->size > a->alloc) return; // out of memory
+    memcpy(a->limbs, b->limbs, b->size * sizeof(bnz_limb_t));
+    a->size = b->size;
     a->sign = b->sign;
 }
 
-int32_t cmp_uint8_arr(uint8_t *a, uint8_t *b, size_t len) // compare two uint8_t arrays a and b, return -1 if a < b, 0 if a == b, and 1 if a > b 
+void bnz_view_i32(bnz_t *a, bnz_limb_t *limb, int32_t b) // make a a bnz_t of b backed by the caller's limb, it needs no allocation
+{
+    *limb = b < 0 ? (bnz_limb_t)(-(int64_t)b) : (bnz_limb_t)b;
+    a->sign = b < 0;
+    a->size = 1;
+    a->alloc = 1;
+    a->ext = 1;
+    a->limbs = limb;
+}
+
+int32_t cmp_limb_arr(bnz_limb_t *a, bnz_limb_t *b, size_t len) // compare two limb arrays a and b, return -1 if a < b, 0 if a == b, and 1 if a > b 
 {
     size_t idx = len;
     while (idx--) {
@@ -1684,767 +2851,2772 @@ int32_t cmp_uint8_arr(uint8_t *a, uint8_t *b, size_t len) // compare two uint8_t
     return 0;
 }
 
-int32_t bnz_cmp_i32(bnz_t *a, int32_t b) // compare bnz_t with int_t, by converting int8_t to bnz_t and invoking bnz_cmp_bnz
+bnz_limb_t add_limb_arr(bnz_limb_t *c, bnz_limb_t *a, bnz_limb_t *b, size_t len) // c = a + b over len limbs, c may alias a or b, return the carry out of the msb limb
 {
-    int32_t res;
-    bnz_t tmp;
-    bnz_init(&tmp);
-    bnz_set_i32(&tmp, b);
-    res = bnz_cmp_bnz(a, &tmp);
-    bnz_free(&tmp);
-    return res;
+    bnz_limb_t s, carry = 0;
+    size_t i;
+    for (i = 0; i < len; i++) {
+        s = a[i] + carry;
+        carry = s < carry ? 1 : 0;
+        s += b[i];
+        if (s < b[i]) carry = 1;
+        c[i] = s;
+    }
+    return carry;
 }
 
-int32_t bnz_cmp_bnz(bnz_t *a, bnz_t *b) // compare two bnz_t numbers, taking account of signs, and invoking cmp_uint8_arr to compare their digits
+bnz_limb_t sub_limb_arr(bnz_limb_t *c, bnz_limb_t *a, bnz_limb_t *b, size_t len) // c = a - b over len limbs, c may alias a or b, return the borrow out of the msb limb
 {
-    size_t res;
-    bnz_t aa, bb;
+    bnz_limb_t d, t, borrow = 0;
+    size_t i;
+    for (i = 0; i < len; i++) {
+        d = a[i] - b[i];
+        t = d - borrow;
+        borrow = (a[i] < b[i] || d < borrow) ? 1 : 0;
+        c[i] = t;
+    }
+    return borrow;
+}
 
-    bnz_init(&aa);
-    bnz_init(&bb);
-    
-    bnz_set_bnz(&aa, a);
-    bnz_set_bnz(&bb, b);
-    bnz_align(&aa, &bb);
-    
-    if (aa.sign != bb.sign) { // signs are different
-        if (aa.sign == 0 && bb.sign != 0) {
-            res = 1; // a > -b
-        } else {
-            res = -1; // -a < b
-        }
-    } else { // signs are the same
-        res = cmp_uint8_arr(aa.digits, bb.digits, aa.size); // compare |a| and |b|
-        switch (res) {
-            case -1: // |a| < |b| => a < b, -a > -b
-                if (aa.sign) res = 1; // reverse cmp value if a and b are negative
-                break;
-            case 1: // |a| > |b| => a > b, -a < -b
-                if (aa.sign) res = -1; // reverse cmp value if a and b are negative
-                break;
-            default:
-                break;
-        }
+bnz_limb_t add_1_limb_arr(bnz_limb_t *c, bnz_limb_t *a, size_t len, bnz_limb_t b) // c = a + b over len limbs for a single limb b, return the carry out of the msb limb
+{
+    size_t i;
+    for (i = 0; i < len; i++) {
+        c[i] = a[i] + b;
+        b = c[i] < b ? 1 : 0;
     }
+    return b;
+}
 
-    bnz_free(&aa);
-    bnz_free(&bb);
+bnz_limb_t sub_1_limb_arr(bnz_limb_t *c, bnz_limb_t *a, size_t len, bnz_limb_t b) // c = a - b over len limbs for a single limb b, return the borrow out of the msb limb
+{
+    bnz_limb_t t;
+    size_t i;
+    for (i = 0; i < len; i++) {
+        t = a[i];
+        c[i] = t - b;
+        b = t < b ? 1 : 0;
+    }
+    return b;
+}
 
-    return res;
+void add_at_limb_arr(bnz_limb_t *r, size_t r_len, size_t off, bnz_limb_t *a, size_t len) // r += a * B^off, limbs of a beyond r_len must be zero, carry propagates up to r_len
+{
+    bnz_limb_t carry;
+    if (len > r_len - off) len = r_len - off;
+    carry = add_limb_arr(r + off, r + off, a, len);
+    add_1_limb_arr(r + off + len, r + off + len, r_len - off - len, carry);
 }
 
-int32_t bnz_is_zero(bnz_t *a) // return 1 if a == 0, return 0 if a != 0
+void neg_limb_arr(bnz_limb_t *a, size_t len) // a = -a in two's complement over len limbs
 {
-    size_t i = a->size;
-    while (i--) {
-        if (a->digits[i] != 0) return 0;
+    size_t i;
+    for (i = 0; i < len; i++) a[i] = ~a[i];
+    add_1_limb_arr(a, a, len, 1);
+}
+
+void shift_r1_signed_limb_arr(bnz_limb_t *a, size_t len) // a = a / 2 for an even two's complement value over len limbs
+{
+    size_t i;
+    for (i = 0; i + 1 < len; i++) {
+        a[i] = (a[i] >> 1) | (a[i + 1] << (BNZ_LIMB_BITS - 1));
     }
-    return 1;
+    a[len - 1] = (bnz_limb_t)((a[len - 1] >> 1) | (a[len - 1] & ((bnz_limb_t)1 << (BNZ_LIMB_BITS - 1)))); // keep the sign bit
 }
 
-int32_t bnz_bit_set(bnz_t *a, uint32_t idx) // return 1 if a specific bit in a is set, return 0 if it is not set
+void divexact_3_limb_arr(bnz_limb_t *a, size_t len) // a = a / 3 for a two's complement multiple of 3 over len limbs, by multiplying with the inverse of 3 mod B
+{
+    bnz_limb_t inv = BNZ_LIMB_MAX / 3 * 2 + 1, s, q, c = 0, borrow;
+    bnz_dlimb_t t;
+    size_t i;
+    for (i = 0; i < len; i++) {
+        s = a[i] - c;
+        borrow = s > a[i] ? 1 : 0;
+        q = s * inv;
+        a[i] = q;
+        t = (bnz_dlimb_t)q * 3;
+        c = borrow + (bnz_limb_t)(t >> BNZ_LIMB_BITS);
+    }
+}
+
+bnz_limb_t mul_add_limb_arr(bnz_limb_t *a, size_t len, bnz_limb_t m, bnz_limb_t c) // a = a * m + c over len limbs, return the carry out of the msb limb
 {
-    uint32_t byte = idx / 8, bit = idx % 8;
-    return (a->digits[byte] >> bit) & 1;
+    bnz_dlimb_t t;
+    size_t i;
+    for (i = 0; i < len; i++) {
+        t = (bnz_dlimb_t)a[i] * m + c;
+        a[i] = (bnz_limb_t)t;
+        c = (bnz_limb_t)(t >> BNZ_LIMB_BITS);
+    }
+    return c;
 }
 
-void bnz_concatenate_ui8(bnz_t *c, bnz_t *a, uint8_t b, size_t order) // convert uint_t to bnz_t and invoke bnz_concatenate_bnz
+void mul_basecase_limb_arr(bnz_limb_t *r, bnz_limb_t *a, size_t a_len, bnz_limb_t *b, size_t b_len) // schoolbook r = a * b, r holds a_len + b_len limbs and must not overlap a or b
 {
-    bnz_t bb;
-    bnz_init(&bb);
-    bnz_resize(&bb, 1, 0);
-    memcpy(bb.digits, &b, 1);
-    bnz_concatenate_bnz(c, a, &bb, order);
-    bnz_free(&bb);
+    bnz_dlimb_t m;
+    bnz_limb_t k;
+    size_t i, j;
+    memset(r, 0, (a_len + b_len) * sizeof(bnz_limb_t));
+    for (i = 0; i < b_len; i++) {
+        if (b[i] == 0) continue;
+        k = 0;
+        for (j = 0; j < a_len; j++) {
+            m = (bnz_dlimb_t)a[j] * b[i] + r[i + j] + k; // at most (2^w - 1)^2 + 2 * (2^w - 1), fits in a double limb
+            r[i + j] = (bnz_limb_t)m;
+            k = (bnz_limb_t)(m >> BNZ_LIMB_BITS);
+        }
+        r[i + a_len] = k;
+    }
 }
 
-void bnz_concatenate_bnz(bnz_t *c, bnz_t *a, bnz_t *b, size_t order) // c = a concatenated to b, in sepcified order
+void mul_limb_arr(bnz_limb_t *r, bnz_limb_t *a, size_t a_len, bnz_limb_t *b, size_t b_len) // r = a * b, r holds a_len + b_len limbs and must not overlap a or b, picking schoolbook, karatsuba or toom-3 by operand size
 {
-    bnz_t cc; // local copy permits a = a || b, a = b || a
-    bnz_init(&cc);
-    bnz_resize(&cc, a->size + b->size, 0);
-    if (order) {
-        memcpy(cc.digits, b->digits, b->size);
-        memcpy(cc.digits + b->size, a->digits, a->size);
+    bnz_limb_t *ws = NULL;
+    bnz_scratch_t *s = NULL;
+    size_t mark, len;
+    if (a_len < b_len) { // longer operand first
+        mul_limb_arr(r, b, b_len, a, a_len);
+        return;
+    }
+    if (b_len < BNZ_KARATSUBA_THRESHOLD) {
+        mul_basecase_limb_arr(r, a, a_len, b, b_len);
+        return;
+    }
+
+    s = bnz_scratch();
+    mark = bnz_scratch_mark(s);
+    len = mul_scratch_size(a_len, b_len) + 1;
+    if (!(ws = bnz_scratch_limbs(s, len))) { // arena busy and full, take the heap
+        if (!(ws = malloc(len * sizeof(bnz_limb_t)))) {
+            mul_basecase_limb_arr(r, a, a_len, b, b_len);
+            return;
+        }
+        bnz_heap_allocs++;
+        s = NULL;
+    }
+
+    if (a_len == b_len) {
+        mul_n_limb_arr(r, a, b, a_len, ws);
     } else {
-        memcpy(cc.digits, a->digits, a->size);
-        memcpy(cc.digits + a->size, b->digits, b->size);
+        mul_unbalanced_limb_arr(r, a, a_len, b, b_len, ws);
+    }
+
+    if (s) {
+        bnz_scratch_rewind(s, mark);
+    } else {
+        free(ws);
     }
-    bnz_set_bnz(c, &cc);
-    bnz_free(&cc);
 }
 
-void bnz_add_i32(bnz_t *c, bnz_t *a, int32_t b) // convert int32_t to bnz_t and invoke bnz_add_bnz
+size_t mul_scratch_size(size_t a_len, size_t b_len) // number of scratch limbs needed by mul_n_limb_arr (a_len == b_len) or mul_unbalanced_limb_arr (a_len > b_len)
 {
-    bnz_t bb;
-    bnz_init(&bb);
-    bnz_set_i32(&bb, b);
-    bnz_add_bnz(c, a, &bb);
+    size_t n = b_len, h, l, k, s1, s2, s3;
+    if (a_len > b_len) { // product buffer for one a block plus the larger of the balanced block product and the leftover product
+        s1 = mul_scratch_size(n, n);
+        s2 = a_len % n ? mul_scratch_size(n, a_len % n) : 0;
+        return 2 * n + (s1 > s2 ? s1 : s2);
+    }
+    if (a_len < b_len) return mul_scratch_size(b_len, a_len);
+    if (n < BNZ_KARATSUBA_THRESHOLD) return 0;
+    if (n < BNZ_TOOM3_THRESHOLD) { // a0 + a1, b0 + b1 and their product
+        h = n / 2;
+        l = n - h;
+        s1 = mul_scratch_size(l + 1, l + 1);
+        s2 = mul_scratch_size(h, h);
+        s3 = mul_scratch_size(l, l);
+        if (s2 > s1) s1 = s2;
+        if (s3 > s1) s1 = s3;
+        return 4 * (l + 1) + s1;
+    }
+    k = (n + 2) / 3; // two evaluations of k + 1 limbs and five products of 2k + 2 limbs
+    s1 = mul_scratch_size(k + 1, k + 1);
+    s2 = mul_scratch_size(k, k);
+    s3 = mul_scratch_size(n - 2 * k, n - 2 * k);
+    if (s2 > s1) s1 = s2;
+    if (s3 > s1) s1 = s3;
+    return 2 * (k + 1) + 10 * (k + 1) + s1;
 }
 
-void bnz_add_bnz(bnz_t *c, bnz_t *a, bnz_t *b) // c = a + b, taking account of signs, invoking bnz_addition or bnz_subtraction
+void mul_n_limb_arr(bnz_limb_t *r, bnz_limb_t *a, bnz_limb_t *b, size_t n, bnz_limb_t *ws) // r = a * b for n limb operands, r holds 2n limbs, ws holds mul_scratch_size(n, n) limbs
 {
-    int32_t cmp;
-    bnz_t tmp, aa, bb;
+    if (n < BNZ_KARATSUBA_THRESHOLD) {
+        mul_basecase_limb_arr(r, a, n, b, n);
+    } else if (n < BNZ_TOOM3_THRESHOLD) {
+        mul_karatsuba_limb_arr(r, a, b, n, ws);
+    } else {
+        mul_toom3_limb_arr(r, a, b, n, ws);
+    }
+}
 
-    bnz_init(&tmp);
-    bnz_init(&aa);
-    bnz_init(&bb);
+void mul_unbalanced_limb_arr(bnz_limb_t *r, bnz_limb_t *a, size_t a_len, bnz_limb_t *b, size_t b_len, bnz_limb_t *ws) // r = a * b for a_len > b_len, cutting a into b_len limb blocks so that each block product is balanced
+{
+    bnz_limb_t *t = ws;
+    size_t i, rem = a_len % b_len;
+    memset(r, 0, (a_len + b_len) * sizeof(bnz_limb_t));
+    for (i = 0; i + b_len <= a_len; i += b_len) {
+        mul_n_limb_arr(t, a + i, b, b_len, ws + 2 * b_len);
+        add_at_limb_arr(r, a_len + b_len, i, t, 2 * b_len);
+    }
+    if (rem) { // leftover block of a, shorter than b
+        if (rem < BNZ_KARATSUBA_THRESHOLD) {
+            mul_basecase_limb_arr(t, b, b_len, a + i, rem);
+        } else {
+            mul_unbalanced_limb_arr(t, b, b_len, a + i, rem, ws + 2 * b_len);
+        }
+        add_at_limb_arr(r, a_len + b_len, i, t, b_len + rem);
+    }
+}
 
-    bnz_set_bnz(&aa, a);
-    bnz_set_bnz(&bb, b);
+void mul_karatsuba_limb_arr(bnz_limb_t *r, bnz_limb_t *a, bnz_limb_t *b, size_t n, bnz_limb_t *ws) // r = a * b with three half size products, r holds 2n limbs
+{
+    size_t h = n / 2, l = n - h; // a = a1 * B^h + a0, with h limbs in a0 and l limbs in a1
+    bnz_limb_t *sa = ws, *sb = ws + (l + 1), *z1 = ws + 2 * (l + 1), *next = ws + 4 * (l + 1);
 
-    bnz_align(&aa, &bb);
-
-    cmp = cmp_uint8_arr(aa.digits, bb.digits, aa.size);
-
-    if (a->sign) { // -a
-        if (b->sign) { // -a, -b
-            bnz_addition(&tmp, &aa, &bb);
-            tmp.sign = 1;
-        } else { // -a, +b
-            if (cmp == -1) { // |a| < |b|
-                bnz_subtraction(&tmp, &bb, &aa);
-                tmp.sign = 0;
-            } else { // |a| >= |b|
-                bnz_subtraction(&tmp, &aa, &bb);
-                tmp.sign = 1;
-            }
-        }
-    } else { // +a
-        if (b->sign) { // +a, -b
-            if (cmp == -1) { // |a| < |b|
-                bnz_subtraction(&tmp, &bb, &aa);
-                tmp.sign = 1;
-            } else { // |a| >= |b|
-                bnz_subtraction(&tmp, &aa, &bb);
-                tmp.sign = 0;
-            }
-        } else { // +a, +b
-            bnz_addition(&tmp, &aa, &bb);
+    sa[l] = add_1_limb_arr(sa + h, a + 2 * h, l - h, add_limb_arr(sa, a + h, a, h)); // sa = a0 + a1
+    sb[l] = add_1_limb_arr(sb + h, b + 2 * h, l - h, add_limb_arr(sb, b + h, b, h)); // sb = b0 + b1
+
+    mul_n_limb_arr(r, a, b, h, next); // z0 = a0 * b0 in r[0 .. 2h]
+    mul_n_limb_arr(r + 2 * h, a + h, b + h, l, next); // z2 = a1 * b1 in r[2h .. 2n]
+    mul_n_limb_arr(z1, sa, sb, l + 1, next);
+
+    sub_1_limb_arr(z1 + 2 * h, z1 + 2 * h, 2 * (l + 1) - 2 * h, sub_limb_arr(z1, z1, r, 2 * h)); // z1 = sa * sb - z0 - z2 = a0 * b1 + a1 * b0
+    sub_1_limb_arr(z1 + 2 * l, z1 + 2 * l, 2, sub_limb_arr(z1, z1, r + 2 * h, 2 * l));
+
+    add_at_limb_arr(r, 2 * n, h, z1, 2 * (l + 1));
+}
+
+void mul_toom3_limb_arr(bnz_limb_t *r, bnz_limb_t *a, bnz_limb_t *b, size_t n, bnz_limb_t *ws) // r = a * b with five third size products, evaluating at 0, 1, -1, -2 and infinity, r holds 2n limbs
+{
+    size_t k = (n + 2) / 3, n2 = n - 2 * k, m = k + 1, len = 2 * m; // a = a2 * B^2k + a1 * B^k + a0, with n2 limbs in a2
+    bnz_limb_t *ea = ws, *eb = ws + m, *w0 = ws + 2 * m, *w1 = w0 + len, *wm1 = w1 + len, *wm2 = wm1 + len, *winf = wm2 + len, *next = winf + len;
+    int32_t sign;
+
+    // r(0) = a0 * b0, r(inf) = a2 * b2
+    memset(w0, 0, len * sizeof(bnz_limb_t));
+    memset(winf, 0, len * sizeof(bnz_limb_t));
+    mul_n_limb_arr(w0, a, b, k, next);
+    mul_n_limb_arr(winf, a + 2 * k, b + 2 * k, n2, next);
+
+    // r(1) = (a0 + a1 + a2) * (b0 + b1 + b2)
+    toom3_eval_limb_arr(ea, a, k, n2, 1);
+    toom3_eval_limb_arr(eb, b, k, n2, 1);
+    mul_n_limb_arr(w1, ea, eb, m, next);
+
+    // r(-1) = (a0 - a1 + a2) * (b0 - b1 + b2)
+    sign = toom3_eval_limb_arr(ea, a, k, n2, -1) ^ toom3_eval_limb_arr(eb, b, k, n2, -1);
+    mul_n_limb_arr(wm1, ea, eb, m, next);
+    if (sign) neg_limb_arr(wm1, len);
+
+    // r(-2) = (a0 - 2a1 + 4a2) * (b0 - 2b1 + 4b2)
+    sign = toom3_eval_limb_arr(ea, a, k, n2, -2) ^ toom3_eval_limb_arr(eb, b, k, n2, -2);
+    mul_n_limb_arr(wm2, ea, eb, m, next);
+    if (sign) neg_limb_arr(wm2, len);
+
+    // interpolation in two's complement over len limbs, the coefficients c1, c2 and c3 end up in w1, wm1 and wm2
+    sub_limb_arr(wm2, wm2, w1, len);
+    divexact_3_limb_arr(wm2, len); // r3 = (r(-2) - r(1)) / 3
+    sub_limb_arr(w1, w1, wm1, len);
+    shift_r1_signed_limb_arr(w1, len); // r1 = (r(1) - r(-1)) / 2
+    sub_limb_arr(wm1, wm1, w0, len); // r2 = r(-1) - r(0)
+    sub_limb_arr(wm2, wm1, wm2, len);
+    shift_r1_signed_limb_arr(wm2, len);
+    add_limb_arr(wm2, wm2, winf, len);
+    add_limb_arr(wm2, wm2, winf, len); // r3 = (r2 - r3) / 2 + 2 r(inf)
+    add_limb_arr(wm1, wm1, w1, len);
+    sub_limb_arr(wm1, wm1, winf, len); // r2 = r2 + r1 - r(inf)
+    sub_limb_arr(w1, w1, wm2, len); // r1 = r1 - r3
+
+    // recomposition, r = c0 + c1 B^k + c2 B^2k + c3 B^3k + c4 B^4k
+    memcpy(r, w0, 2 * k * sizeof(bnz_limb_t));
+    memset(r + 2 * k, 0, 2 * k * sizeof(bnz_limb_t));
+    memcpy(r + 4 * k, winf, 2 * n2 * sizeof(bnz_limb_t));
+    add_at_limb_arr(r, 2 * n, k, w1, len);
+    add_at_limb_arr(r, 2 * n, 2 * k, wm1, len);
+    add_at_limb_arr(r, 2 * n, 3 * k, wm2, len);
+}
+
+int32_t toom3_eval_limb_arr(bnz_limb_t *e, bnz_limb_t *a, size_t k, size_t n2, int32_t x) // e = |a0 + x a1 + x^2 a2| over k + 1 limbs for x = 1, -1 or -2, return 1 if the value is negative
+{
+    bnz_limb_t *a1 = a + k, *a2 = a + 2 * k;
+    size_t m = k + 1;
+
+    memset(e, 0, m * sizeof(bnz_limb_t));
+    memcpy(e, a2, n2 * sizeof(bnz_limb_t));
+    if (x == -2) add_limb_arr(e, e, e, m); // 2 a2
+    if (x == 1) {
+        e[k] = add_limb_arr(e, e, a1, k) + e[k];
+    } else {
+        sub_1_limb_arr(e + k, e + k, 1, sub_limb_arr(e, e, a1, k));
+    }
+    if (x == -2) add_limb_arr(e, e, e, m); // 4 a2 - 2 a1
+    e[k] += add_limb_arr(e, e, a, k);
+
+    if (x != 1 && e[k] >> (BNZ_LIMB_BITS - 1)) { // negative in two's complement
+        neg_limb_arr(e, m);
+        return 1;
+    }
+    return 0;
+}
+
+void sqr_basecase_limb_arr(bnz_limb_t *r, bnz_limb_t *a, size_t n) // schoolbook r = a^2, r holds 2n limbs and must not overlap a, each cross product a[i] * a[j] is computed once and doubled
+{
+    bnz_dlimb_t m;
+    bnz_limb_t k;
+    size_t i, j;
+    memset(r, 0, 2 * n * sizeof(bnz_limb_t));
+    for (i = 0; i < n; i++) { // cross products a[i] * a[j] with j > i
+        k = 0;
+        for (j = i + 1; j < n; j++) {
+            m = (bnz_dlimb_t)a[j] * a[i] + r[i + j] + k;
+            r[i + j] = (bnz_limb_t)m;
+            k = (bnz_limb_t)(m >> BNZ_LIMB_BITS);
         }
+        r[i + n] = k;
+    }
+    add_limb_arr(r, r, r, 2 * n); // double the cross products
+    k = 0;
+    for (i = 0; i < n; i++) { // add the squares a[i]^2 on the diagonal
+        m = (bnz_dlimb_t)a[i] * a[i] + r[2 * i] + k;
+        r[2 * i] = (bnz_limb_t)m;
+        m = (bnz_dlimb_t)r[2 * i + 1] + (bnz_limb_t)(m >> BNZ_LIMB_BITS);
+        r[2 * i + 1] = (bnz_limb_t)m;
+        k = (bnz_limb_t)(m >> BNZ_LIMB_BITS);
     }
+}
 
-    bnz_trim(&tmp);
+void sqr_limb_arr(bnz_limb_t *r, bnz_limb_t *a, size_t n) // r = a^2, r holds 2n limbs and must not overlap a, picking schoolbook, karatsuba or toom-3 by operand size
+{
+    bnz_limb_t *ws = NULL;
+    bnz_scratch_t *s = NULL;
+    size_t mark, len;
+    if (n < BNZ_KARATSUBA_THRESHOLD) {
+        sqr_basecase_limb_arr(r, a, n);
+        return;
+    }
 
-    bnz_set_bnz(c, &tmp);
+    s = bnz_scratch();
+    mark = bnz_scratch_mark(s);
+    len = mul_scratch_size(n, n) + 1;
+    if (!(ws = bnz_scratch_limbs(s, len))) { // arena busy and full, take the heap
+        if (!(ws = malloc(len * sizeof(bnz_limb_t)))) {
+            sqr_basecase_limb_arr(r, a, n);
+            return;
+        }
+        bnz_heap_allocs++;
+        s = NULL;
+    }
 
-    bnz_free(&tmp);
-    bnz_free(&aa);
-    bnz_free(&bb);
+    sqr_n_limb_arr(r, a, n, ws);
+
+    if (s) {
+        bnz_scratch_rewind(s, mark);
+    } else {
+        free(ws);
+    }
 }
 
-void bnz_addition(bnz_t *c, bnz_t *a, bnz_t *b) // |a| + |b|
+void sqr_n_limb_arr(bnz_limb_t *r, bnz_limb_t *a, size_t n, bnz_limb_t *ws) // r = a^2 for an n limb operand, r holds 2n limbs, ws holds mul_scratch_size(n, n) limbs
 {
-    size_t i, carry = 0;
-    bnz_t tmp;
-    bnz_init(&tmp);
-    bnz_resize(&tmp, a->size + 1, 0);
-    for (i = 0; i < a->size; i++) {
-        tmp.digits[i] = a->digits[i] + carry;
-        carry = tmp.digits[i] < carry ? 1 : 0;
-        tmp.digits[i] += b->digits[i];
-        if (tmp.digits[i] < b->digits[i]) carry = 1;
-    }
-    tmp.digits[a->size] = carry;
-    bnz_set_bnz(c, &tmp);
-    bnz_free(&tmp);
+    if (n < BNZ_KARATSUBA_THRESHOLD) {
+        sqr_basecase_limb_arr(r, a, n);
+    } else if (n < BNZ_TOOM3_THRESHOLD) {
+        sqr_karatsuba_limb_arr(r, a, n, ws);
+    } else {
+        mul_toom3_limb_arr(r, a, a, n, ws);
+    }
 }
 
-void bnz_subtract_bnz(bnz_t *c, bnz_t *a, bnz_t *b) // c = a - b, taking account of signs, invoking bnz_subtraction or bnz_addition
+void sqr_karatsuba_limb_arr(bnz_limb_t *r, bnz_limb_t *a, size_t n, bnz_limb_t *ws) // r = a^2 with three half size squares, r holds 2n limbs
 {
-    int32_t cmp;
-    bnz_t tmp, aa, bb;
+    size_t h = n / 2, l = n - h; // a = a1 * B^h + a0, with h limbs in a0 and l limbs in a1
+    bnz_limb_t *sa = ws, *z1 = ws + (l + 1), *next = ws + 3 * (l + 1);
 
-    bnz_init(&tmp);
-    bnz_init(&aa);
-    bnz_init(&bb);
+    sa[l] = add_1_limb_arr(sa + h, a + 2 * h, l - h, add_limb_arr(sa, a + h, a, h)); // sa = a0 + a1
 
-    bnz_set_bnz(&aa, a);
-    bnz_set_bnz(&bb, b);
+    sqr_n_limb_arr(r, a, h, next); // z0 = a0^2 in r[0 .. 2h]
+    sqr_n_limb_arr(r + 2 * h, a + h, l, next); // z2 = a1^2 in r[2h .. 2n]
+    sqr_n_limb_arr(z1, sa, l + 1, next);
 
-    bnz_align(&aa, &bb);
+    sub_1_limb_arr(z1 + 2 * h, z1 + 2 * h, 2 * (l + 1) - 2 * h, sub_limb_arr(z1, z1, r, 2 * h)); // z1 = sa^2 - z0 - z2 = 2 * a0 * a1
+    sub_1_limb_arr(z1 + 2 * l, z1 + 2 * l, 2, sub_limb_arr(z1, z1, r + 2 * h, 2 * l));
 
-    cmp = cmp_uint8_arr(aa.digits, bb.digits, aa.size);
+    add_at_limb_arr(r, 2 * n, h, z1, 2 * (l + 1));
+}
 
-    if (a->sign) { // -a
-        if (b->sign) { // -a, -b
-            if (cmp == -1) { // |a| < |b|
-                bnz_subtraction(&tmp, &bb, &aa);
-                tmp.sign = 0;
-            } else { // |a| >= |b|
-                bnz_subtraction(&tmp, &aa, &bb);
-                tmp.sign = 1;
-            }
-        } else { // -a, +b
-            bnz_addition(&tmp, &aa, &bb);
-            tmp.sign = 1;
-        }
-    } else { // +a
-        if (b->sign) { // +a, -b
-            bnz_addition(&tmp, &aa, &bb);
-            tmp.sign = 0;
-        } else { // +a, +b
-            if (cmp == -1) { // |a| < |b|
-                bnz_subtraction(&tmp, &bb, &aa);
-                tmp.sign = 1;
-            } else { // |a| >= |b|
-                bnz_subtraction(&tmp, &aa, &bb);
-                tmp.sign = 0;
-            }
+bnz_limb_t reciprocal_limb(bnz_limb_t d) // v = (B^2 - 1) / d - B for a normalized d (highest bit set), B = 2^BNZ_LIMB_BITS
+{
+    return (bnz_limb_t)((((bnz_dlimb_t)(bnz_limb_t)~d << BNZ_LIMB_BITS) | BNZ_LIMB_MAX) / d);
+}
+
+bnz_limb_t reciprocal_2_limb(bnz_limb_t d1, bnz_limb_t d0) // v = (B^3 - 1) / (d1 * B + d0) - B for a normalized d1, B = 2^BNZ_LIMB_BITS
+{
+    bnz_limb_t v = reciprocal_limb(d1), p = d1 * v, t1, t0;
+    bnz_dlimb_t t;
+
+    p += d0;
+    if (p < d0) {
+        v--;
+        if (p >= d1) {
+            v--;
+            p -= d1;
         }
+        p -= d1;
     }
 
-    bnz_trim(&tmp);
+    t = (bnz_dlimb_t)v * d0;
+    t1 = (bnz_limb_t)(t >> BNZ_LIMB_BITS);
+    t0 = (bnz_limb_t)t;
 
-    bnz_set_bnz(c, &tmp);
+    p += t1;
+    if (p < t1) {
+        v--;
+        if (p > d1 || (p == d1 && t0 >= d0)) v--;
+    }
+    return v;
+}
 
-    bnz_free(&tmp);
-    bnz_free(&aa);
-    bnz_free(&bb);
+bnz_limb_t div_2by1_limb(bnz_limb_t *r, bnz_limb_t u1, bnz_limb_t u0, bnz_limb_t d, bnz_limb_t v) // return (u1 * B + u0) / d and set r to the remainder, u1 < d, d normalized with v = reciprocal_limb(d)
+{
+    bnz_dlimb_t q = (bnz_dlimb_t)v * u1 + (((bnz_dlimb_t)u1 << BNZ_LIMB_BITS) | u0);
+    bnz_limb_t q1 = (bnz_limb_t)(q >> BNZ_LIMB_BITS) + 1, q0 = (bnz_limb_t)q, rem;
+
+    rem = u0 - q1 * d;
+    if (rem > q0) {
+        q1--;
+        rem += d;
+    }
+    if (rem >= d) { // unlikely
+        q1++;
+        rem -= d;
+    }
+    *r = rem;
+    return q1;
 }
 
-void bnz_subtraction(bnz_t *c, bnz_t *a, bnz_t *b) // c = |a| - |b|
+bnz_limb_t div_3by2_limb(bnz_limb_t *r1, bnz_limb_t *r0, bnz_limb_t u2, bnz_limb_t u1, bnz_limb_t u0, bnz_limb_t d1, bnz_limb_t d0, bnz_limb_t v) // return (u2 * B^2 + u1 * B + u0) / (d1 * B + d0) and set r1, r0 to the remainder, (u2, u1) < (d1, d0), d1 normalized with v = reciprocal_2_limb(d1, d0)
 {
-    size_t i, borrow = 0;
-    bnz_t tmp;
-    bnz_init(&tmp);
-    bnz_resize(&tmp, a->size, 0);
-    for (i = 0; i < a->size; i++) {
-        tmp.digits[i] = a->digits[i] - borrow;
-        borrow = tmp.digits[i] > 255 - borrow ? 1 : 0;
-        tmp.digits[i] -= b->digits[i];
-        if (tmp.digits[i] > 255 - b->digits[i]) borrow = 1;
-    }
-    bnz_set_bnz(c, &tmp);
-    bnz_free(&tmp);
+    bnz_dlimb_t q = (bnz_dlimb_t)v * u2 + (((bnz_dlimb_t)u2 << BNZ_LIMB_BITS) | u1);
+    bnz_dlimb_t d = ((bnz_dlimb_t)d1 << BNZ_LIMB_BITS) | d0, rem;
+    bnz_limb_t q1 = (bnz_limb_t)(q >> BNZ_LIMB_BITS), q0 = (bnz_limb_t)q;
+
+    rem = ((bnz_dlimb_t)(bnz_limb_t)(u1 - q1 * d1) << BNZ_LIMB_BITS) | u0;
+    rem -= (bnz_dlimb_t)d0 * q1 + d;
+    q1++;
+
+    if ((bnz_limb_t)(rem >> BNZ_LIMB_BITS) >= q0) {
+        q1--;
+        rem += d;
+    }
+    if (rem >= d) { // unlikely
+        q1++;
+        rem -= d;
+    }
+    *r1 = (bnz_limb_t)(rem >> BNZ_LIMB_BITS);
+    *r0 = (bnz_limb_t)rem;
+    return q1;
 }
 
-void bnz_multiply_i32(bnz_t *c, bnz_t *a, int32_t b) // convert int32_t to bnz_t and invoke bnz_multiply_bnz
+bnz_limb_t submul_1_limb_arr(bnz_limb_t *a, bnz_limb_t *b, size_t len, bnz_limb_t m) // a = a - b * m over len limbs, return the borrow limb
 {
-    bnz_t bb;
-    bnz_init(&bb);
-    bnz_set_i32(&bb, b);
-    bnz_multiply_bnz(c, a, &bb);
-    bnz_free(&bb);
+    bnz_dlimb_t p;
+    bnz_limb_t k = 0, lo, t;
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        p = (bnz_dlimb_t)b[i] * m + k;
+        lo = (bnz_limb_t)p;
+        k = (bnz_limb_t)(p >> BNZ_LIMB_BITS);
+        t = a[i];
+        a[i] = t - lo;
+        k += t < lo;
+    }
+    return k;
 }
 
-void bnz_multiply_bnz(bnz_t *c, bnz_t *a, bnz_t *b) // c = |a| * |b|
+bnz_limb_t addmul_1_limb_arr(bnz_limb_t *a, bnz_limb_t *b, size_t len, bnz_limb_t m) // a = a + b * m over len limbs, return the carry limb
 {
-    uint8_t k, t[2];
-    uint16_t m;
-    size_t i, j;
-    bnz_t tmp, aa, bb;
+    bnz_dlimb_t p;
+    bnz_limb_t k = 0;
+    size_t i;
 
-    bnz_init(&tmp);
-    bnz_init(&aa);
-    bnz_init(&bb);
+    for (i = 0; i < len; i++) {
+        p = (bnz_dlimb_t)b[i] * m + a[i] + k;
+        a[i] = (bnz_limb_t)p;
+        k = (bnz_limb_t)(p >> BNZ_LIMB_BITS);
+    }
+    return k;
+}
 
-    bnz_set_bnz(&aa, a);
-    bnz_set_bnz(&bb, b);
+bnz_limb_t div_limb_arr(bnz_limb_t *a, size_t len, bnz_limb_t d) // a = a / d over len limbs, return the remainder, one reciprocal of the normalized d replaces a hardware division per limb
+{
+    bnz_limb_t v, rem, lo;
+    size_t i = len;
+    uint32_t sh = 0;
+
+    while (!((d << sh) >> (BNZ_LIMB_BITS - 1))) sh++;
+    d <<= sh;
+    v = reciprocal_limb(d);
+
+    rem = sh && len ? a[len - 1] >> (BNZ_LIMB_BITS - sh) : 0;
+    while (i--) {
+        lo = (a[i] << sh) | (sh && i ? a[i - 1] >> (BNZ_LIMB_BITS - sh) : 0);
+        a[i] = div_2by1_limb(&rem, rem, lo, d, v);
+    }
+    return rem >> sh;
+}
+
+void divmod_limb_arr(bnz_limb_t *q, bnz_limb_t *r, bnz_limb_t *a, size_t a_len, bnz_limb_t *b, size_t n, bnz_limb_t *an, bnz_limb_t *bn) // q = a / b and r = a % b with b[n - 1] != 0 and a_len >= n, q holds a_len - n + 1 limbs or is NULL for the remainder only, r holds n limbs, an (a_len + 1 limbs) and bn (n limbs) are scratch space, an may alias r and bn may alias b
+{
+    bnz_limb_t tmp = b[n - 1], v, d1, d0, q_j, r1, r0, cy, cy1;
+    size_t m = a_len - n, i, j;
+    uint32_t sh = 0;
+
+    while (!(tmp >> (BNZ_LIMB_BITS - 1))) { // measure left shift required to ensure that the highest bit of bn[n - 1] is set
+        sh++;
+        tmp <<= 1;
+    }
+
+    // an, from the top so that an may alias a
+    an[m + n] = sh ? a[m + n - 1] >> (BNZ_LIMB_BITS - sh) : 0;
+    for (i = m + n - 1; i > 0; i--) {
+        an[i] = (a[i] << sh) | (sh ? a[i - 1] >> (BNZ_LIMB_BITS - sh) : 0);
+    }
+    an[0] = a[0] << sh;
+
+    // bn, from the top so that bn may alias b
+    for (i = n - 1; i > 0; i--) {
+        bn[i] = (b[i] << sh) | (sh ? b[i - 1] >> (BNZ_LIMB_BITS - sh) : 0);
+    }
+    bn[0] = b[0] << sh;
+
+    if (n == 1) { // single limb divisor, short division
+        d1 = bn[0];
+        v = reciprocal_limb(d1);
+        r1 = an[m + 1];
+        for (j = m + 1; j-- > 0;) {
+            q_j = div_2by1_limb(&r1, r1, an[j], d1, v);
+            if (q) q[j] = q_j;
+        }
+        r[0] = r1 >> sh;
+        return;
+    }
+
+    d1 = bn[n - 1];
+    d0 = bn[n - 2];
+    v = reciprocal_2_limb(d1, d0);
+
+    // main loop, each quotient limb comes from a 3 by 2 division of the top of an by the top of bn
+    for (j = m + 1; j-- > 0;) {
+        if (an[j + n] == d1 && an[j + n - 1] == d0) { // the 3 by 2 division would overflow, the quotient limb is B - 1
+            q_j = BNZ_LIMB_MAX;
+            an[j + n] -= submul_1_limb_arr(an + j, bn, n, q_j);
+        } else {
+            q_j = div_3by2_limb(&r1, &r0, an[j + n], an[j + n - 1], an[j + n - 2], d1, d0, v);
+
+            // subtract q_j * bn[0 .. n - 2) from an[j .. j + n - 2) and carry the borrow into (r1, r0)
+            cy = submul_1_limb_arr(an + j, bn, n - 2, q_j);
+            cy1 = r0 < cy;
+            r0 -= cy;
+            cy = r1 < cy1;
+            r1 -= cy1;
+            an[j + n - 2] = r0;
+
+            if (cy) { // q_j was one too large, add bn back
+                r1 += d1 + add_limb_arr(an + j, an + j, bn, n - 1);
+                q_j--;
+            }
+            an[j + n - 1] = r1;
+            an[j + n] = 0;
+        }
+        if (q) q[j] = q_j;
+    }
+
+    for (i = 0; i < n; i++) {
+        r[i] = (an[i] >> sh) | (sh ? an[i + 1] << (BNZ_LIMB_BITS - sh) : 0);
+    }
+}
+
+void mont_redc_limb_arr(bnz_limb_t *r, bnz_limb_t *t, bnz_limb_t *m, size_t n, bnz_limb_t m_inv) // r = t / B^n mod m for t < m * B^n over 2n limbs and m_inv = -m^-1 mod B, t is clobbered, r holds n limbs
+{
+    bnz_limb_t c, s, cy = 0;
+    size_t i;
+
+    for (i = 0; i < n; i++) { // add the multiple of m that clears t[i]
+        c = addmul_1_limb_arr(t + i, m, n, t[i] * m_inv);
+        s = t[i + n] + cy;
+        cy = s < cy;
+        t[i + n] = s + c;
+        cy += t[i + n] < c;
+    }
+
+    if (cy || cmp_limb_arr(t + n, m, n) >= 0) { // t / B^n < 2m
+        sub_limb_arr(r, t + n, m, n);
+    } else {
+        memcpy(r, t + n, n * sizeof(bnz_limb_t));
+    }
+}
+
+void barrett_limb_arr(bnz_limb_t *r, bnz_limb_t *x, bnz_limb_t *m, size_t k, bnz_limb_t *mu, size_t mu_len, bnz_limb_t *ws) // r = x % m for x < B^(2k) over 2k limbs, m of k limbs with m[k - 1] != 0, mu = B^(2k) / m over mu_len limbs, r holds k limbs, ws holds mu_len + 4k + 3 limbs
+{
+    bnz_limb_t *q2 = ws, *t = ws + k + 1 + mu_len, *rr = t + 2 * k + 1;
+
+    mul_basecase_limb_arr(q2, x + k - 1, k + 1, mu, mu_len); // q2 = (x / B^(k - 1)) * mu
+    mul_basecase_limb_arr(t, q2 + k + 1, k + 1, m, k); // t = (q2 / B^(k + 1)) * m, q2 / B^(k + 1) <= x / m fits k + 1 limbs
+
+    sub_limb_arr(rr, x, t, k + 1); // x - t mod B^(k + 1), the estimate falls short of x / m by at most 2
+    while (rr[k] || cmp_limb_arr(rr, m, k) >= 0) {
+        rr[k] -= sub_limb_arr(rr, rr, m, k);
+    }
+    memcpy(r, rr, k * sizeof(bnz_limb_t));
+}
+
+int32_t bnz_cmp_i32(bnz_t *a, int32_t b) // compare bnz_t with int32_t, through a stack view of b
+{
+    bnz_limb_t limb;
+    bnz_t bb;
+    bnz_view_i32(&bb, &limb, b);
+    return bnz_cmp_bnz(a, &bb);
+}
+
+int32_t bnz_cmp_bnz(bnz_t *a, bnz_t *b) // compare two bnz_t numbers, taking account of signs, and invoking cmp_limb_arr to compare their limbs
+{
+    size_t a_len = a->size, b_len = b->size;
+    int32_t res;
+
+    while (a_len > 0 && a->limbs[a_len - 1] == 0) a_len--;
+    while (b_len > 0 && b->limbs[b_len - 1] == 0) b_len--;
+
+    if (a_len == 0 && b_len == 0) return 0; // 0 == -0
+
+    if ((a_len && a->sign) != (b_len && b->sign)) { // signs are different, the sign of 0 is ignored
+        return (a_len && a->sign) ? -1 : 1; // -a < b, a > -b
+    }
+
+    if (a_len != b_len) {
+        res = a_len < b_len ? -1 : 1;
+    } else {
+        res = cmp_limb_arr(a->limbs, b->limbs, a_len); // compare |a| and |b|
+    }
+    return (a_len && a->sign) ? -res : res; // reverse cmp value if a and b are negative
+}
+
+int32_t bnz_is_zero(bnz_t *a) // return 1 if a == 0, return 0 if a != 0
+{
+    size_t i = a->size;
+    while (i--) {
+        if (a->limbs[i] != 0) return 0;
+    }
+    return 1;
+}
+
+int32_t bnz_bit_set(bnz_t *a, uint32_t idx) // return 1 if a specific bit in a is set, return 0 if it is not set
+{
+    size_t limb = idx / BNZ_LIMB_BITS, bit = idx % BNZ_LIMB_BITS;
+    if (limb >= a->size) return 0;
+    return (a->limbs[limb] >> bit) & 1;
+}
+
+size_t bnz_bit_length(bnz_t *a) // return the number of significant bits in |a|, 0 for a == 0
+{
+    size_t n = a->size;
+    bnz_limb_t top;
+    uint32_t bits = 0;
+
+    while (n > 0 && a->limbs[n - 1] == 0) n--;
+    if (n == 0) return 0;
+    for (top = a->limbs[n - 1]; top; top >>= 1) bits++;
+    return (n - 1) * BNZ_LIMB_BITS + bits;
+}
+
+void bnz_add_i32(bnz_t *c, bnz_t *a, int32_t b) // c = a + b, through a stack view of b
+{
+    bnz_limb_t limb;
+    bnz_t bb;
+    bnz_view_i32(&bb, &limb, b);
+    bnz_add_bnz(c, a, &bb);
+}
+
+void bnz_add_bnz(bnz_t *c, bnz_t *a, bnz_t *b) // c = a + b, taking account of signs, invoking bnz_add_signed
+{
+    bnz_add_signed(c, a, b, b->sign);
+}
+
+void bnz_add_signed(bnz_t *c, bnz_t *a, bnz_t *b, size_t b_sign) // c = a + b with the sign of b taken as b_sign, c may alias a or b, no temporaries
+{
+    size_t a_len = a->size, b_len = b->size, sign = a->sign, len;
+    int32_t cmp;
+    bnz_t *t;
+
+    while (a_len > 1 && a->limbs[a_len - 1] == 0) a_len--;
+    while (b_len > 1 && b->limbs[b_len - 1] == 0) b_len--;
+
+    if (a->sign == b_sign) { // |c| = |a| + |b| with the common sign
+        if (a_len < b_len) { // a is the longer operand
+            t = a; a = b; b = t;
+            len = a_len; a_len = b_len; b_len = len;
+        }
+        bnz_reserve(c, a_len + 1); // may move the limbs of a or b when c aliases them
+        if (a_len + 1 > c->alloc) return;
+        c->limbs[a_len] = add_1_limb_arr(c->limbs + b_len, a->limbs + b_len, a_len - b_len, add_limb_arr(c->limbs, a->limbs, b->limbs, b_len));
+        c->size = a_len + 1;
+    } else { // |c| = ||a| - |b|| with the sign of the larger magnitude
+        cmp = a_len != b_len ? (a_len < b_len ? -1 : 1) : cmp_limb_arr(a->limbs, b->limbs, a_len);
+        if (cmp == -1) { // |a| < |b|
+            t = a; a = b; b = t;
+            len = a_len; a_len = b_len; b_len = len;
+            sign = b_sign;
+        }
+        bnz_reserve(c, a_len);
+        if (a_len > c->alloc) return;
+        sub_1_limb_arr(c->limbs + b_len, a->limbs + b_len, a_len - b_len, sub_limb_arr(c->limbs, a->limbs, b->limbs, b_len));
+        c->size = a_len;
+    }
+    c->sign = sign;
+
+    bnz_trim(c);
+}
+
+void bnz_addition(bnz_t *c, bnz_t *a, bnz_t *b) // |a| + |b|
+{
+    bnz_add_signed(c, a, b, a->sign);
+    c->sign = 0;
+}
+
+void bnz_subtract_bnz(bnz_t *c, bnz_t *a, bnz_t *b) // c = a - b, taking account of signs, invoking bnz_add_signed with the sign of b flipped
+{
+    bnz_add_signed(c, a, b, b->sign ^ 1);
+}
+
+void bnz_subtraction(bnz_t *c, bnz_t *a, bnz_t *b) // c = |a| - |b| for |a| >= |b|
+{
+    bnz_add_signed(c, a, b, a->sign ^ 1);
+    c->sign = 0;
+}
+
+void bnz_add_inplace(bnz_t *a, bnz_t *b) // a = a + b, reusing the capacity of a
+{
+    bnz_add_signed(a, a, b, b->sign);
+}
+
+void bnz_sub_inplace(bnz_t *a, bnz_t *b) // a = a - b, reusing the capacity of a
+{
+    bnz_add_signed(a, a, b, b->sign ^ 1);
+}
+
+void bnz_addmul_limb(bnz_t *c, bnz_t *a, bnz_limb_t m, size_t off, size_t sign) // c = c + |a| * m * B^off with the sign of the product term taken as sign, c may alias a when off is 0
+{
+    size_t a_len = a->size, c_len = c->size, n;
+    bnz_limb_t cy;
+
+    while (a_len > 1 && a->limbs[a_len - 1] == 0) a_len--;
+    while (c_len > 1 && c->limbs[c_len - 1] == 0) c_len--;
+    n = (c_len > a_len + off ? c_len : a_len + off) + 1;
+
+    bnz_resize(c, n, 1);
+    if (n > c->size) return;
+
+    if (c->sign == sign) { // magnitudes add
+        cy = addmul_1_limb_arr(c->limbs + off, a->limbs, a_len, m);
+        add_1_limb_arr(c->limbs + off + a_len, c->limbs + off + a_len, n - off - a_len, cy);
+    } else { // magnitudes subtract, negate if the product term was larger
+        cy = submul_1_limb_arr(c->limbs + off, a->limbs, a_len, m);
+        if (sub_1_limb_arr(c->limbs + off + a_len, c->limbs + off + a_len, n - off - a_len, cy)) {
+            neg_limb_arr(c->limbs, n);
+            c->sign ^= 1;
+        }
+    }
+
+    bnz_trim(c);
+}
+
+void bnz_addmul_ui32(bnz_t *c, bnz_t *a, uint32_t m) // c = c + a * m in place
+{
+    bnz_addmul_limb(c, a, m, 0, a->sign);
+}
+
+void bnz_submul_ui32(bnz_t *c, bnz_t *a, uint32_t m) // c = c - a * m in place
+{
+    bnz_addmul_limb(c, a, m, 0, a->sign ^ 1);
+}
+
+void bnz_addmul(bnz_t *c, bnz_t *a, bnz_t *b) // c = c + a * b in place, one limb of b at a time, c must not alias a or b
+{
+    size_t i, sign = a->sign ^ b->sign;
+    for (i = 0; i < b->size; i++) {
+        if (b->limbs[i]) bnz_addmul_limb(c, a, b->limbs[i], i, sign);
+    }
+}
+
+void bnz_submul(bnz_t *c, bnz_t *a, bnz_t *b) // c = c - a * b in place, one limb of b at a time, c must not alias a or b
+{
+    size_t i, sign = a->sign ^ b->sign ^ 1;
+    for (i = 0; i < b->size; i++) {
+        if (b->limbs[i]) bnz_addmul_limb(c, a, b->limbs[i], i, sign);
+    }
+}
+
+void bnz_multiply_i32(bnz_t *c, bnz_t *a, int32_t b) // c = a * b, through a stack view of b
+{
+    bnz_limb_t limb;
+    bnz_t bb;
+    bnz_view_i32(&bb, &limb, b);
+    bnz_multiply_bnz(c, a, &bb);
+}
+
+void bnz_multiply_bnz(bnz_t *c, bnz_t *a, bnz_t *b) // c = a * b, written straight into c unless c aliases an operand
+{
+    size_t a_len = a->size, b_len = b->size, sign = a->sign ^ b->sign;
+    bnz_limb_t buf[BNZ_STACK_LIMBS], *r = buf;
+    bnz_scratch_t *s = bnz_scratch();
+    size_t mark = bnz_scratch_mark(s);
+
+    while (a_len > 1 && a->limbs[a_len - 1] == 0) a_len--; // operands keep their own lengths, a short * long product costs a_len * b_len
+    while (b_len > 1 && b->limbs[b_len - 1] == 0) b_len--;
+
+    if (c != a && c != b) {
+        bnz_reserve(c, a_len + b_len);
+        if (a_len + b_len > c->alloc) return;
+        mul_limb_arr(c->limbs, a->limbs, a_len, b->limbs, b_len);
+    } else { // product into a stack or scratch temporary, then into c
+        if (a_len + b_len > BNZ_STACK_LIMBS && !(r = bnz_scratch_limbs(s, a_len + b_len))) { // arena busy and full, take the heap
+            if (!(r = malloc((a_len + b_len) * sizeof(bnz_limb_t)))) return;
+            bnz_heap_allocs++;
+            s = NULL;
+        }
+        mul_limb_arr(r, a->limbs, a_len, b->limbs, b_len);
+        bnz_reserve(c, a_len + b_len);
+        if (a_len + b_len <= c->alloc) memcpy(c->limbs, r, (a_len + b_len) * sizeof(bnz_limb_t));
+        if (s) {
+            bnz_scratch_rewind(s, mark);
+        } else {
+            free(r);
+        }
+        if (a_len + b_len > c->alloc) return;
+    }
+    c->size = a_len + b_len;
+    c->sign = sign;
+
+    bnz_trim(c);
+}
+
+void bnz_square(bnz_t *c, bnz_t *a) // c = a^2, using the symmetric cross products, written straight into c unless c aliases a
+{
+    size_t a_len = a->size;
+    bnz_limb_t buf[BNZ_STACK_LIMBS], *r = buf;
+    bnz_scratch_t *s = bnz_scratch();
+    size_t mark = bnz_scratch_mark(s);
+
+    while (a_len > 1 && a->limbs[a_len - 1] == 0) a_len--;
+
+    if (c != a) {
+        bnz_reserve(c, 2 * a_len);
+        if (2 * a_len > c->alloc) return;
+        sqr_limb_arr(c->limbs, a->limbs, a_len);
+    } else { // square into a stack or scratch temporary, then into c
+        if (2 * a_len > BNZ_STACK_LIMBS && !(r = bnz_scratch_limbs(s, 2 * a_len))) { // arena busy and full, take the heap
+            if (!(r = malloc((2 * a_len) * sizeof(bnz_limb_t)))) return;
+            bnz_heap_allocs++;
+            s = NULL;
+        }
+        sqr_limb_arr(r, a->limbs, a_len);
+        bnz_reserve(c, 2 * a_len);
+        if (2 * a_len <= c->alloc) memcpy(c->limbs, r, 2 * a_len * sizeof(bnz_limb_t));
+        if (s) {
+            bnz_scratch_rewind(s, mark);
+        } else {
+            free(r);
+        }
+        if (2 * a_len > c->alloc) return;
+    }
+    c->size = 2 * a_len;
+    c->sign = 0;
+
+    bnz_trim(c);
+}
+
+void bnz_division_signs(bnz_t *q, bnz_t *r, bnz_t *a, bnz_t *b) // process signs of q and r in a / b, q may be NULL
+{
+    r->sign = a->sign; // r takes the sign of a
+    if (q) q->sign = a->sign ^ b->sign; // q is negative when the signs differ
+}
+
+void bnz_divide_bnz(bnz_t *q, bnz_t *r, bnz_t *a, bnz_t *b) // get q and r of a / b, taking account of signs, invoking bnz_division, q may be NULL for the remainder only
+{
+    int32_t cmp;
+    bnz_scratch_t *s = bnz_scratch();
+    size_t mark = bnz_scratch_mark(s);
+
+    bnz_t aa, bb;
+
+    bnz_scratch_bnz(s, &aa, a->size);
+    bnz_scratch_bnz(s, &bb, b->size);
+
+    bnz_set_bnz(&aa, a);
+    bnz_set_bnz(&bb, b);
+    bnz_trim(&aa);
+    bnz_trim(&bb);
+
+    aa.sign = 0;
+    bb.sign = 0;
+
+    if (bnz_is_zero(&bb)) { // divide by 0
+        printf("div 0 error\n");
+        if (q) bnz_set_i32(q, 0);
+        bnz_set_i32(r, 0);
+        bnz_free(&aa);
+        bnz_free(&bb);
+        bnz_scratch_rewind(s, mark);
+        return;
+    }
+
+    cmp = bnz_cmp_bnz(&aa, &bb);
+
+    if (cmp == 0) { // |aa| = |bb|
+        if (q) bnz_set_i32(q, 1);
+        bnz_set_i32(r, 0);
+    } else if (cmp == -1) { // |aa| < |bb|
+        if (q) bnz_set_i32(q, 0);
+        bnz_set_bnz(r, &aa);
+    } else { // |aa| > |bb|
+        bnz_division(q, r, &aa, &bb);
+    }
+    bnz_division_signs(q, r, a, b);
+
+    bnz_free(&aa);
+    bnz_free(&bb);
+    bnz_scratch_rewind(s, mark);
+}
+
+void bnz_division(bnz_t *q, bnz_t *r, bnz_t *a, bnz_t *b) // get q and r of |a| / |b|, q may be NULL, b is normalized in place and r doubles as the normalized dividend so no scratch is allocated
+{
+    size_t n = b->size, m = a->size - b->size;
+
+    if (q) bnz_resize(q, m + 1, 0);
+    bnz_resize(r, m + n + 1, 0);
+
+    divmod_limb_arr(q ? q->limbs : NULL, r->limbs, a->limbs, a->size, b->limbs, n, r->limbs, b->limbs);
+
+    r->size = n;
+    if (q) bnz_trim(q);
+    bnz_trim(r);
+}
+
+void bnz_mod_bnz(bnz_t *c, bnz_t *a, bnz_t *b) // get c = a % b, invoking bnz_divide_bnz without a quotient
+{
+    bnz_t r;
+    bnz_scratch_t *s = bnz_scratch();
+    size_t mark = bnz_scratch_mark(s);
+
+    bnz_scratch_bnz(s, &r, (a->size > b->size ? a->size : b->size) + 1);
+    
+    bnz_divide_bnz(NULL, &r, a, b);
+    bnz_trim(&r);
+    if (r.sign) bnz_add_bnz(&r, &r, b);
+    bnz_set_bnz(c, &r);
+    
+    bnz_free(&r);
+    bnz_scratch_rewind(s, mark);
+}
+
+uint32_t bnz_pow_window(size_t bits) // sliding window size for an exponent of bits bits, at most 6 bits
+{
+    if (bits > 671) return 6;
+    if (bits > 239) return 5;
+    if (bits > 79) return 4;
+    if (bits > 23) return 3;
+    return 1;
+}
+
+uint32_t bnz_pow_window_bits(bnz_t *e, size_t i, uint32_t w, uint32_t *len) // return the window of at most w bits of e from the set bit i downwards, shortened to end on a set bit, and its length in len
+{
+    uint32_t l = i + 1 < w ? i + 1 : w, val = 0, k;
+
+    while (!bnz_bit_set(e, i + 1 - l)) l--;
+    for (k = 0; k < l; k++) val = (val << 1) | bnz_bit_set(e, i - k);
+
+    *len = l;
+    return val;
+}
+
+void bnz_mod_pow(bnz_t *d, bnz_t *a, bnz_t *b, bnz_t *c) // get d = a^b mod c by left to right sliding window exponentiation, through a montgomery context when c is odd
+{
+    bnz_t g[32], acc; // odd powers a, a^3, .. a^(2^w - 1)
+    bnz_mont_ctx ctx;
+    bnz_scratch_t *s = bnz_scratch();
+    size_t rem = bnz_bit_length(b), n, k, mark = bnz_scratch_mark(s);
+    uint32_t w, len, val;
+
+    if (bnz_mont_init_scratch(&ctx, c, s)) {
+        bnz_mod_pow_mont(d, a, b, &ctx);
+        bnz_mont_free(&ctx);
+        bnz_scratch_rewind(s, mark);
+        return;
+    }
+    bnz_mont_free(&ctx);
+    bnz_scratch_rewind(s, mark);
+
+    if (b->sign || rem == 0) { // a^0, negative exponents are treated as 0
+        bnz_set_i32(d, 1);
+        return;
+    }
+
+    w = bnz_pow_window(rem);
+    n = (size_t)1 << (w - 1);
+
+    bnz_scratch_bnz(s, &acc, 2 * c->size + 1);
+    for (k = 0; k < n; k++) bnz_scratch_bnz(s, &g[k], 2 * c->size + 1);
+
+    bnz_mod_bnz(&g[0], a, c);
+    if (n > 1) {
+        bnz_square(&acc, &g[0]);
+        bnz_mod_bnz(&acc, &acc, c); // acc = a^2
+    }
+    for (k = 1; k < n; k++) {
+        bnz_multiply_bnz(&g[k], &g[k - 1], &acc);
+        bnz_mod_bnz(&g[k], &g[k], c);
+    }
+
+    val = bnz_pow_window_bits(b, rem - 1, w, &len);
+    bnz_set_bnz(&acc, &g[val >> 1]);
+    rem -= len;
+
+    while (rem > 0) {
+        if (!bnz_bit_set(b, rem - 1)) {
+            bnz_square(&acc, &acc);
+            bnz_mod_bnz(&acc, &acc, c);
+            rem--;
+            continue;
+        }
+        val = bnz_pow_window_bits(b, rem - 1, w, &len);
+        for (k = 0; k < len; k++) {
+            bnz_square(&acc, &acc);
+            bnz_mod_bnz(&acc, &acc, c);
+        }
+        bnz_multiply_bnz(&acc, &acc, &g[val >> 1]);
+        bnz_mod_bnz(&acc, &acc, c);
+        rem -= len;
+    }
+
+    bnz_set_bnz(d, &acc);
+
+    bnz_free(&acc);
+    for (k = 0; k < n; k++) bnz_free(&g[k]);
+    bnz_scratch_rewind(s, mark);
+}
+
+void bnz_modular_multiplicative_inverse(bnz_t *c, bnz_t *a, bnz_t *b) // get c where (c * a) mod b = 1
+{
+    bnz_t q, rem, t, new_t, r, new_r, tmp;
+    bnz_scratch_t *s = bnz_scratch();
+    size_t mark = bnz_scratch_mark(s), n = (a->size > b->size ? a->size : b->size) + 1; // every temporary stays below max(|a|, |b|)
+
+    bnz_scratch_bnz(s, &q, n);
+    bnz_scratch_bnz(s, &rem, n);
+    bnz_scratch_bnz(s, &t, n);
+    bnz_scratch_bnz(s, &new_t, n);
+    bnz_scratch_bnz(s, &r, n);
+    bnz_scratch_bnz(s, &new_r, n);
+
+    bnz_set_i32(&t, 0);
+    bnz_set_i32(&new_t, 1);
+    bnz_set_bnz(&r, b);
+    bnz_set_bnz(&new_r, a);
+
+    while (!bnz_is_zero(&new_r)) {
+        bnz_divide_bnz(&q, &rem, &r, &new_r);
+        bnz_submul(&t, &q, &new_t);
+        tmp = t; // (t, new_t) = (new_t, t - q * new_t), swapping buffers rather than copying
+        t = new_t;
+        new_t = tmp;
+        tmp = r; // (r, new_r) = (new_r, r - q * new_r), rem keeps the old buffer of r for the next round
+        r = new_r;
+        new_r = rem;
+        rem = tmp;
+    }
+
+    if (bnz_cmp_i32(&r, 1) == 1) {
+        bnz_set_i32(c, 0);
+    } else {
+        if (t.sign) bnz_add_bnz(&t, &t, b);
+        bnz_set_bnz(c, &t);
+    }
+
+    bnz_free(&q);
+    bnz_free(&rem);
+    bnz_free(&t);
+    bnz_free(&new_t);
+    bnz_free(&r);
+    bnz_free(&new_r);
+    bnz_scratch_rewind(s, mark);
+}
+
+int32_t bnz_mont_init(bnz_mont_ctx *ctx, bnz_t *m) // set up a montgomery context for an odd modulus m > 1, return 0 if m is not usable, bnz_mont_free must be called either way
+{
+    return bnz_mont_init_scratch(ctx, m, NULL);
+}
+
+int32_t bnz_mont_init_scratch(bnz_mont_ctx *ctx, bnz_t *m, bnz_scratch_t *s) // same as bnz_mont_init with the context carved from s when s is not NULL, valid until s is rewound past it
+{
+    bnz_limb_t m0, inv;
+    size_t n, i;
+
+    ctx->t = NULL;
+    ctx->ext = 0;
+    if (s) {
+        bnz_scratch_bnz(s, &ctx->m, m->size);
+        bnz_scratch_bnz(s, &ctx->r2, 2 * m->size + 1);
+        ctx->t = bnz_scratch_limbs(s, 2 * m->size);
+        ctx->ext = ctx->t != NULL;
+    } else {
+        bnz_init(&ctx->m);
+        bnz_init(&ctx->r2);
+    }
+
+    bnz_set_bnz(&ctx->m, m);
+    bnz_trim(&ctx->m);
+    if (m->sign || !(ctx->m.limbs[0] & 1) || bnz_cmp_i32(&ctx->m, 1) != 1) return 0;
+
+    n = ctx->m.size;
+    m0 = ctx->m.limbs[0];
+
+    inv = m0; // correct to 3 bits for odd m0, each newton step doubles that
+    for (i = 0; i < 6; i++) inv *= 2 - m0 * inv;
+    ctx->m_inv = (bnz_limb_t)0 - inv;
+
+    bnz_resize(&ctx->r2, 2 * n + 1, 0); // R^2 = B^(2 * n)
+    ctx->r2.limbs[2 * n] = 1;
+    bnz_mod_bnz(&ctx->r2, &ctx->r2, &ctx->m);
+    bnz_resize(&ctx->r2, n, 1);
+
+    if (!ctx->t) {
+        if (!(ctx->t = malloc(2 * n * sizeof(bnz_limb_t)))) return 0;
+        bnz_heap_allocs++;
+    }
+    return 1;
+}
+
+void bnz_mont_free(bnz_mont_ctx *ctx) // free montgomery context components
+{
+    bnz_free(&ctx->m);
+    bnz_free(&ctx->r2);
+    if (!ctx->ext) free(ctx->t);
+    ctx->t = NULL;
+}
+
+void bnz_mont_mul(bnz_t *c, bnz_t *a, bnz_t *b, bnz_mont_ctx *ctx) // c = a * b / R mod m for a, b < m in montgomery form
+{
+    size_t n = ctx->m.size, a_len = a->size, b_len = b->size;
+
+    while (a_len > 1 && a->limbs[a_len - 1] == 0) a_len--;
+    while (b_len > 1 && b->limbs[b_len - 1] == 0) b_len--;
+
+    memset(ctx->t, 0, 2 * n * sizeof(bnz_limb_t));
+    if (a == b) {
+        sqr_limb_arr(ctx->t, a->limbs, a_len);
+    } else {
+        mul_limb_arr(ctx->t, a->limbs, a_len, b->limbs, b_len);
+    }
+
+    if (c->size != n) bnz_resize(c, n, 0);
+    c->sign = 0;
+    mont_redc_limb_arr(c->limbs, ctx->t, ctx->m.limbs, n, ctx->m_inv);
+}
+
+void bnz_mont_sqr(bnz_t *c, bnz_t *a, bnz_mont_ctx *ctx) // c = a^2 / R mod m for a < m in montgomery form
+{
+    bnz_mont_mul(c, a, a, ctx);
+}
+
+void bnz_to_mont(bnz_t *c, bnz_t *a, bnz_mont_ctx *ctx) // c = a * R mod m, reducing a first if it is negative or not below m
+{
+    bnz_t tmp;
+    bnz_scratch_t *s = NULL;
+    size_t mark;
+
+    if (!a->sign && bnz_cmp_bnz(a, &ctx->m) == -1) {
+        bnz_mont_mul(c, a, &ctx->r2, ctx);
+        return;
+    }
+
+    s = bnz_scratch();
+    mark = bnz_scratch_mark(s);
+    bnz_scratch_bnz(s, &tmp, a->size + 1);
+    bnz_mod_bnz(&tmp, a, &ctx->m);
+    bnz_mont_mul(c, &tmp, &ctx->r2, ctx);
+    bnz_free(&tmp);
+    bnz_scratch_rewind(s, mark);
+}
+
+void bnz_from_mont(bnz_t *c, bnz_t *a, bnz_mont_ctx *ctx) // c = a / R mod m for a < m in montgomery form
+{
+    size_t n = ctx->m.size, a_len = a->size < n ? a->size : n;
+
+    memset(ctx->t, 0, 2 * n * sizeof(bnz_limb_t));
+    memcpy(ctx->t, a->limbs, a_len * sizeof(bnz_limb_t));
+
+    if (c->size != n) bnz_resize(c, n, 0);
+    c->sign = 0;
+    mont_redc_limb_arr(c->limbs, ctx->t, ctx->m.limbs, n, ctx->m_inv);
+    bnz_trim(c);
+}
+
+void bnz_mod_pow_mont(bnz_t *d, bnz_t *a, bnz_t *b, bnz_mont_ctx *ctx) // get d = a^b mod m by left to right sliding window exponentiation, all products reduced by montgomery reduction instead of division
+{
+    bnz_t g[32], acc; // odd powers a, a^3, .. a^(2^w - 1) in montgomery form
+    size_t rem = bnz_bit_length(b), n, k, mark;
+    bnz_scratch_t *s = NULL;
+    uint32_t w, len, val;
+
+    if (b->sign || rem == 0) { // a^0, negative exponents are treated as 0 like bnz_mod_pow
+        bnz_set_i32(d, 1);
+        return;
+    }
+
+    w = bnz_pow_window(rem);
+    n = (size_t)1 << (w - 1);
+
+    s = bnz_scratch();
+    mark = bnz_scratch_mark(s);
+    bnz_scratch_bnz(s, &acc, ctx->m.size);
+    for (k = 0; k < n; k++) bnz_scratch_bnz(s, &g[k], ctx->m.size);
+
+    bnz_to_mont(&g[0], a, ctx);
+    if (n > 1) bnz_mont_sqr(&acc, &g[0], ctx); // acc = a^2
+    for (k = 1; k < n; k++) bnz_mont_mul(&g[k], &g[k - 1], &acc, ctx);
+
+    val = bnz_pow_window_bits(b, rem - 1, w, &len);
+    bnz_set_bnz(&acc, &g[val >> 1]);
+    rem -= len;
+
+    while (rem > 0) {
+        if (!bnz_bit_set(b, rem - 1)) {
+            bnz_mont_sqr(&acc, &acc, ctx);
+            rem--;
+            continue;
+        }
+        val = bnz_pow_window_bits(b, rem - 1, w, &len);
+        for (k = 0; k < len; k++) bnz_mont_sqr(&acc, &acc, ctx);
+        bnz_mont_mul(&acc, &acc, &g[val >> 1], ctx);
+        rem -= len;
+    }
+
+    bnz_from_mont(d, &acc, ctx);
+
+    bnz_free(&acc);
+    for (k = 0; k < n; k++) bnz_free(&g[k]);
+    bnz_scratch_rewind(s, mark);
+}
+
+/* U256 */
+
+#define U256_LIMBS (256 / BNZ_LIMB_BITS)
+
+typedef struct {
+    bnz_limb_t limbs[U256_LIMBS]; // least significant limb first
+} u256_t;
+
+typedef struct {
+    bnz_limb_t limbs[2 * U256_LIMBS]; // least significant limb first
+} u512_t;
+
+typedef struct {
+    u256_t m; // modulus
+    size_t k; // limbs in m
+    bnz_limb_t mu[U256_LIMBS + 2]; // B^(2k) / m
+    size_t mu_len; // limbs in mu
+} u256_barrett_t;
+
+#if BNZ_LIMB_BITS == 64
+#define U256_LIMB64(x) (x) // one 64 bit word of a constant as limbs, least significant first
+#else
+#define U256_LIMB64(x) (bnz_limb_t)(x), (bnz_limb_t)((uint64_t)(x) >> 32)
+#endif
+#define U256_CONST(d3, d2, d1, d0) {{U256_LIMB64(d0), U256_LIMB64(d1), U256_LIMB64(d2), U256_LIMB64(d3)}} // u256_t initializer from 64 bit words, most significant first
+
+void u256_set_ui32(u256_t *, uint32_t);
+void u256_set_bytes(u256_t *, const uint8_t *);
+void u256_get_bytes(u256_t *, uint8_t *);
+void u256_set_bnz(u256_t *, bnz_t *);
+void u256_print(u256_t *, int32_t, const char *);
+void u512_set_bytes(u512_t *, const uint8_t *);
+void u512_get_bytes(u512_t *, uint8_t *);
+void u512_print(u512_t *, int32_t, const char *);
+
+int32_t u256_cmp(u256_t *, u256_t *);
+int32_t u256_is_zero(u256_t *);
+int32_t u256_bit_set(u256_t *, uint32_t);
+uint32_t u256_get_bits(u256_t *, uint32_t, uint32_t);
+
+bnz_limb_t u256_add(u256_t *, u256_t *, u256_t *);
+bnz_limb_t u256_sub(u256_t *, u256_t *, u256_t *);
+void u256_mul(u512_t *, u256_t *, u256_t *);
+void u256_mod(u256_t *, u256_t *, u256_t *);
+void u512_mod(u256_t *, u512_t *, u256_t *);
+
+void u256_mod_add(u256_t *, u256_t *, u256_t *, u256_t *);
+void u256_mod_sub(u256_t *, u256_t *, u256_t *, u256_t *);
+
+void u512_barrett_mod(u256_t *, u512_t *, u256_barrett_t *);
+void u256_barrett_mul(u256_t *, u256_t *, u256_t *, u256_barrett_t *);
+
+void u256_set_ui32(u256_t *a, uint32_t b) // convert uint32_t to u256_t
+{
+    memset(a->limbs, 0, sizeof(a->limbs));
+    a->limbs[0] = b;
+}
+
+void u256_set_bytes(u256_t *a, const uint8_t *bytes) // set u256_t to the number represented by 32 bytes in big endian order
+{
+    set_bytes_limb_arr(a->limbs, U256_LIMBS, bytes, 32);
+}
+
+void u256_get_bytes(u256_t *a, uint8_t *bytes) // write a to 32 bytes in big endian order
+{
+    get_bytes_limb_arr(a->limbs, U256_LIMBS, bytes, 32);
+}
+
+void u256_set_bnz(u256_t *a, bnz_t *b) // set u256_t to the 256 least significant bits of |b|
+{
+    size_t n = b->size < U256_LIMBS ? b->size : U256_LIMBS;
+    memset(a->limbs, 0, sizeof(a->limbs));
+    memcpy(a->limbs, b->limbs, n * sizeof(bnz_limb_t));
+}
+
+void u256_print(u256_t *a, int32_t base, const char *txt) // print a in a given base through a temporary bnz_t
+{
+    bnz_t tmp;
+    bnz_scratch_t *s = bnz_scratch();
+    size_t mark = bnz_scratch_mark(s);
+
+    bnz_scratch_bnz(s, &tmp, U256_LIMBS);
+    bnz_set_limbs(&tmp, a->limbs, U256_LIMBS);
+    bnz_print(&tmp, base, txt);
+    bnz_free(&tmp);
+    bnz_scratch_rewind(s, mark);
+}
+
+void u512_set_bytes(u512_t *a, const uint8_t *bytes) // set u512_t to the number represented by 64 bytes in big endian order
+{
+    set_bytes_limb_arr(a->limbs, 2 * U256_LIMBS, bytes, 64);
+}
+
+void u512_get_bytes(u512_t *a, uint8_t *bytes) // write a to 64 bytes in big endian order
+{
+    get_bytes_limb_arr(a->limbs, 2 * U256_LIMBS, bytes, 64);
+}
+
+void u512_print(u512_t *a, int32_t base, const char *txt) // print a in a given base through a temporary bnz_t
+{
+    bnz_t tmp;
+    bnz_scratch_t *s = bnz_scratch();
+    size_t mark = bnz_scratch_mark(s);
+
+    bnz_scratch_bnz(s, &tmp, 2 * U256_LIMBS);
+    bnz_set_limbs(&tmp, a->limbs, 2 * U256_LIMBS);
+    bnz_print(&tmp, base, txt);
+    bnz_free(&tmp);
+    bnz_scratch_rewind(s, mark);
+}
+
+int32_t u256_cmp(u256_t *a, u256_t *b) // return -1 if a < b, 0 if a == b, and 1 if a > b
+{
+    return cmp_limb_arr(a->limbs, b->limbs, U256_LIMBS);
+}
+
+int32_t u256_is_zero(u256_t *a) // return 1 if a == 0, return 0 if a != 0
+{
+    size_t i;
+    for (i = 0; i < U256_LIMBS; i++) {
+        if (a->limbs[i] != 0) return 0;
+    }
+    return 1;
+}
+
+int32_t u256_bit_set(u256_t *a, uint32_t idx) // return 1 if a specific bit in a is set, return 0 if it is not set
+{
+    if (idx >= 256) return 0;
+    return (a->limbs[idx / BNZ_LIMB_BITS] >> (idx % BNZ_LIMB_BITS)) & 1;
+}
+
+uint32_t u256_get_bits(u256_t *a, uint32_t idx, uint32_t len) // return len <= 32 bits of a starting at bit idx, bits past 255 read as 0
+{
+    uint32_t val = 0, k;
+    for (k = len; k > 0; k--) val = (val << 1) | u256_bit_set(a, idx + k - 1);
+    return val;
+}
+
+bnz_limb_t u256_add(u256_t *c, u256_t *a, u256_t *b) // c = a + b mod 2^256, return the carry
+{
+    return add_limb_arr(c->limbs, a->limbs, b->limbs, U256_LIMBS);
+}
+
+bnz_limb_t u256_sub(u256_t *c, u256_t *a, u256_t *b) // c = a - b mod 2^256, return the borrow
+{
+    return sub_limb_arr(c->limbs, a->limbs, b->limbs, U256_LIMBS);
+}
+
+void u256_mul(u512_t *c, u256_t *a, u256_t *b) // c = a * b
+{
+    mul_basecase_limb_arr(c->limbs, a->limbs, U256_LIMBS, b->limbs, U256_LIMBS);
+}
+
+void u256_mod(u256_t *r, u256_t *a, u256_t *m) // r = a % m, m != 0
+{
+    u512_t aa;
+    if (u256_cmp(a, m) < 0) { // already reduced
+        *r = *a;
+        return;
+    }
+    memset(aa.limbs, 0, sizeof(aa.limbs));
+    memcpy(aa.limbs, a->limbs, sizeof(a->limbs));
+    u512_mod(r, &aa, m);
+}
+
+void u512_mod(u256_t *r, u512_t *a, u256_t *m) // r = a % m, m != 0, using stack scratch space only
+{
+    bnz_limb_t rem[U256_LIMBS], an[2 * U256_LIMBS + 1], bn[U256_LIMBS];
+    size_t a_len = 2 * U256_LIMBS, m_len = U256_LIMBS;
+
+    while (m_len > 1 && m->limbs[m_len - 1] == 0) m_len--;
+    while (a_len > 1 && a->limbs[a_len - 1] == 0) a_len--;
+
+    memset(rem, 0, sizeof(rem));
+    if (a_len < m_len) {
+        memcpy(rem, a->limbs, a_len * sizeof(bnz_limb_t));
+    } else {
+        divmod_limb_arr(NULL, rem, a->limbs, a_len, m->limbs, m_len, an, bn); // remainder only
+    }
+    memcpy(r->limbs, rem, sizeof(rem));
+}
+
+void u256_mod_add(u256_t *c, u256_t *a, u256_t *b, u256_t *m) // c = (a + b) % m, for a, b < m
+{
+    if (u256_add(c, a, b) || u256_cmp(c, m) >= 0) u256_sub(c, c, m);
+}
+
+void u256_mod_sub(u256_t *c, u256_t *a, u256_t *b, u256_t *m) // c = (a - b) % m, for a, b < m
+{
+    if (u256_sub(c, a, b)) u256_add(c, c, m);
+}
+
+void u512_barrett_mod(u256_t *r, u512_t *a, u256_barrett_t *ctx) // r = a % m with two multiplications and at most two subtractions
+{
+    bnz_limb_t ws[U256_LIMBS + 2 + 4 * U256_LIMBS + 3];
+    size_t k = ctx->k, a_len = 2 * U256_LIMBS;
+
+    while (a_len > 2 * k && a->limbs[a_len - 1] == 0) a_len--;
+    if (a_len > 2 * k) { // a >= B^(2k) is out of barrett range, only possible for moduli shorter than 256 bits
+        u512_mod(r, a, &ctx->m);
+        return;
+    }
+
+    memset(r->limbs, 0, sizeof(r->limbs));
+    barrett_limb_arr(r->limbs, a->limbs, ctx->m.limbs, k, ctx->mu, ctx->mu_len, ws);
+}
+
+void u256_barrett_mul(u256_t *c, u256_t *a, u256_t *b, u256_barrett_t *ctx) // c = (a * b) % m
+{
+    u512_t t;
+    u256_mul(&t, a, b);
+    u512_barrett_mod(c, &t, ctx);
+}
+
+/* SECP256K1 */
+
+typedef struct {
+    bnz_limb_t limbs[U256_LIMBS]; // least significant limb first, any value below 2^256, reduced below p only by fe_normalize
+} fe_t; // element of the secp256k1 base field, p = 2^256 - 2^32 - 977
+
+#define FE_C_LIMBS (64 / BNZ_LIMB_BITS) // limbs in fe_c
+
+#if BNZ_LIMB_BITS == 64
+const fe_t fe_c = {{0x1000003D1}}; // 2^256 mod p = 2^32 + 977
+#else
+const fe_t fe_c = {{0x3D1, 1}};
+#endif
+
+#if BNZ_LIMB_BITS == 64
+typedef int64_t modinv_limb_t; // signed 62 bit limbs for the safegcd inverse, products of two fit a signed 128 bit intermediate
+typedef uint64_t modinv_ulimb_t;
+typedef __int128 modinv_dlimb_t;
+#define MODINV_BITS 62
+#define MODINV_LIMBS 5
+#define MODINV_STEPS 59 // divsteps per transition matrix in the constant time loop, 10 * 59 = 590
+#else
+typedef int32_t modinv_limb_t; // signed 30 bit limbs with 64 bit intermediates where __int128 is not available
+typedef uint32_t modinv_ulimb_t;
+typedef int64_t modinv_dlimb_t;
+#define MODINV_BITS 30
+#define MODINV_LIMBS 9
+#define MODINV_STEPS 30 // 20 * 30 = 600
+#endif
+
+#define MODINV_MASK (((modinv_ulimb_t)1 << MODINV_BITS) - 1)
+#define MODINV_ROUNDS ((590 + MODINV_STEPS - 1) / MODINV_STEPS) // 590 divsteps always bring g to 0 for moduli and inputs below 2^256
+#define MODINV_SIGN(x) ((x) >> (sizeof(modinv_limb_t) * 8 - 1)) // -1 for negative limbs, 0 otherwise
+
+typedef struct {
+    modinv_limb_t v[MODINV_LIMBS]; // value sum v[i] * 2^(i * MODINV_BITS), limbs below the top one are in [0, 2^MODINV_BITS) after a round
+} modinv_signed_t;
+
+typedef struct {
+    modinv_signed_t m; // odd modulus, limbs may be negative to keep them sparse
+    modinv_ulimb_t m_inv; // m^-1 mod 2^MODINV_BITS
+} modinv_mod_t;
+
+typedef struct {
+    modinv_limb_t u, v, q, r; // 2^MODINV_BITS times the matrix taking (f, g) to (f', g') over a round of divsteps
+} modinv_trans_t;
+
+#if BNZ_LIMB_BITS == 64
+const modinv_mod_t secp256k1_modinv_p = {{{-0x1000003D1LL, 0, 0, 0, 256}}, 0x27C7F6E22DDACACFULL}; // p = 2^256 - 2^32 - 977
+#else
+const modinv_mod_t secp256k1_modinv_p = {{{-0x3D1L, -4L, 0, 0, 0, 0, 0, 0, 65536L}}, 0x2DDACACFUL};
+#endif
+
+typedef struct {
+    u256_t x;
+    u256_t y;
+} PT; // affine point, (0, 0) stands for the point at infinity
+
+typedef struct {
+    fe_t x;
+    fe_t y;
+    fe_t z;
+    int32_t infinity; // 1 for the point at infinity, x, y and z are then ignored
+} PTJ; // jacobian point, the affine point (x / z^2, y / z^3)
+
+#define SECP256K1_GEN_WINDOW 4 // bits of the scalar per lookup in the fixed base table
+#define SECP256K1_GEN_WINDOWS (256 / SECP256K1_GEN_WINDOW)
+#define SECP256K1_GEN_POINTS ((1 << SECP256K1_GEN_WINDOW) - 1)
+
+#define SECP256K1_BATCH 64 // points converted to affine per shared inversion, bounds the stack used by the batch functions
+
+#define SECP256K1_WNAF_WINDOW 5 // width of the naf digits of variable base scalars, 2^(w - 2) odd multiples are precomputed per call
+#define SECP256K1_WNAF_G_WINDOW 8 // width of the naf digits of G scalars in dual multiplications, over the odd multiples kept in secp256k1_gen_odd
+#define SECP256K1_GEN_ODD (1 << (SECP256K1_WNAF_G_WINDOW - 2))
+
+#ifndef SECP256K1_GLV
+#define SECP256K1_GLV 1 // split variable base scalars in two 128 bit halves through the endomorphism lambda * (x, y) = (beta * x, y), build with -DSECP256K1_GLV=0 to compare
+#endif
+
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_ATOMICS__)
+#define SECP256K1_ATOMIC _Atomic
+#define SECP256K1_CAS(p, e, d) atomic_compare_exchange_strong(p, e, d)
+#define SECP256K1_LOAD_ACQUIRE(p) atomic_load_explicit(p, memory_order_acquire)
+#define SECP256K1_STORE_RELEASE(p, v) atomic_store_explicit(p, v, memory_order_release)
+#else
+#define SECP256K1_ATOMIC volatile // single threaded builds only
+#define SECP256K1_CAS(p, e, d) (*(p) == *(e) ? (*(p) = (d), 1) : (*(e) = *(p), 0))
+#define SECP256K1_LOAD_ACQUIRE(p) (*(p))
+#define SECP256K1_STORE_RELEASE(p, v) (*(p) = (v))
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SECP256K1_PAUSE() __builtin_ia32_pause() // spin wait hint, frees the core for the sibling thread filling the table
+#elif defined(__GNUC__) && defined(__aarch64__)
+#define SECP256K1_PAUSE() __asm__ __volatile__("yield")
+#else
+#define SECP256K1_PAUSE()
+#endif
+
+PT secp256k1_gen_table[SECP256K1_GEN_WINDOWS][SECP256K1_GEN_POINTS]; // [i][j] = (j + 1) * 2^(4i) * G, 960 affine points, 60 KB with 64 bit limbs
+PT secp256k1_gen_odd[2][SECP256K1_GEN_ODD]; // [0][i] = (2i + 1) * G and [1][i] = (2i + 1) * lambda * G, filled with secp256k1_gen_table
+SECP256K1_ATOMIC int32_t secp256k1_gen_table_state = 0; // 0 empty, 1 being filled by one thread, 2 ready
+
+typedef struct {
+    u256_t p;
+    u256_t a;
+    u256_t b;
+    PT G;
+    u256_t n;
+    u256_t h;
+    u256_barrett_t n_barrett; // reduction mod n for scalar products
+    u256_t lambda; // cube root of unity mod n, lambda * (x, y) = (beta * x, y)
+    u256_t beta; // cube root of unity mod p
+    u256_t g1; // round(2^384 * a1 / n) for the scalar split, a1 = -b2
+    u256_t g2; // round(2^384 * -b1 / n)
+    u256_t minus_b1; // -b1 of the short lattice basis (a1, b1), (a2, b2) of k1 + k2 * lambda = 0 mod n
+    u256_t minus_b2; // -b2 mod n
+    PT (*gen_table)[SECP256K1_GEN_POINTS]; // fixed base table, filled once by secp256k1_gen_table_init
+    PT (*gen_odd)[SECP256K1_GEN_ODD]; // odd multiples of G and lambda * G for naf digits, filled with gen_table
+} SECP256K1;
+
+const SECP256K1 secp256k1_ctx = { // the curve, compiled in and shared read only by every thread
+    U256_CONST(0xFFFFFFFFFFFFFFFFULL, 0xFFFFFFFFFFFFFFFFULL, 0xFFFFFFFFFFFFFFFFULL, 0xFFFFFFFEFFFFFC2FULL), // prime
+    U256_CONST(0, 0, 0, 0),
+    U256_CONST(0, 0, 0, 7),
+    {
+        U256_CONST(0x79BE667EF9DCBBACULL, 0x55A06295CE870B07ULL, 0x029BFCDB2DCE28D9ULL, 0x59F2815B16F81798ULL), // generator x
+        U256_CONST(0x483ADA7726A3C465ULL, 0x5DA4FBFC0E1108A8ULL, 0xFD17B448A6855419ULL, 0x9C47D08FFB10D4B8ULL) // generator y
+    },
+    U256_CONST(0xFFFFFFFFFFFFFFFFULL, 0xFFFFFFFFFFFFFFFEULL, 0xBAAEDCE6AF48A03BULL, 0xBFD25E8CD0364141ULL), // order
+    U256_CONST(0, 0, 0, 1),
+    {
+        U256_CONST(0xFFFFFFFFFFFFFFFFULL, 0xFFFFFFFFFFFFFFFEULL, 0xBAAEDCE6AF48A03BULL, 0xBFD25E8CD0364141ULL),
+        U256_LIMBS,
+        {U256_LIMB64(0x402DA1732FC9BEC0ULL), U256_LIMB64(0x4551231950B75FC4ULL), U256_LIMB64(1ULL), U256_LIMB64(0ULL), U256_LIMB64(1ULL)}, // 2^512 / n
+        U256_LIMBS + 1
+    },
+    U256_CONST(0x5363AD4CC05C30E0ULL, 0xA5261C028812645AULL, 0x122E22EA20816678ULL, 0xDF02967C1B23BD72ULL), // glv constants
+    U256_CONST(0x7AE96A2B657C0710ULL, 0x6E64479EAC3434E9ULL, 0x9CF0497512F58995ULL, 0xC1396C28719501EEULL),
+    U256_CONST(0x3086D221A7D46BCDULL, 0xE86C90E49284EB15ULL, 0x3DAA8A1471E8CA7FULL, 0xE893209A45DBB031ULL),
+    U256_CONST(0xE4437ED6010E8828ULL, 0x6F547FA90ABFE4C4ULL, 0x221208AC9DF506C6ULL, 0x1571B4AE8AC47F71ULL),
+    U256_CONST(0, 0, 0xE4437ED6010E8828ULL, 0x6F547FA90ABFE4C3ULL),
+    U256_CONST(0xFFFFFFFFFFFFFFFFULL, 0xFFFFFFFFFFFFFFFEULL, 0x8A280AC50774346DULL, 0xD765CDA83DB1562CULL),
+    secp256k1_gen_table,
+    secp256k1_gen_odd
+};
+
+void modinv_set_u256(modinv_signed_t *, u256_t *);
+void modinv_get_u256(u256_t *, modinv_signed_t *);
+modinv_limb_t modinv_divsteps(modinv_limb_t, modinv_ulimb_t, modinv_ulimb_t, modinv_trans_t *);
+uint32_t modinv_ctz(modinv_ulimb_t);
+modinv_limb_t modinv_divsteps_var(modinv_limb_t, modinv_ulimb_t, modinv_ulimb_t, modinv_trans_t *);
+void modinv_update_de(modinv_signed_t *, modinv_signed_t *, modinv_trans_t *, const modinv_mod_t *);
+void modinv_update_fg(modinv_signed_t *, modinv_signed_t *, modinv_trans_t *, size_t);
+void modinv_normalize(modinv_signed_t *, modinv_limb_t, const modinv_mod_t *);
+void modinv(u256_t *, u256_t *, const modinv_mod_t *);
+void modinv_var(u256_t *, u256_t *, const modinv_mod_t *);
+
+void fe_set_u256(fe_t *, u256_t *);
+void fe_get_u256(u256_t *, fe_t *);
+void fe_set_ui32(fe_t *, uint32_t);
+void fe_normalize(fe_t *, fe_t *);
+int32_t fe_is_zero(fe_t *);
+int32_t fe_equal(fe_t *, fe_t *);
+void fe_fold_limb_arr(bnz_limb_t *, bnz_limb_t *, size_t);
+void fe_reduce(fe_t *, bnz_limb_t *);
+void fe_add(fe_t *, fe_t *, fe_t *);
+void fe_sub(fe_t *, fe_t *, fe_t *);
+void fe_negate(fe_t *, fe_t *);
+void fe_mul_ui32(fe_t *, fe_t *, uint32_t);
+void fe_mul(fe_t *, fe_t *, fe_t *);
+void fe_sqr(fe_t *, fe_t *);
+void fe_sqr_n(fe_t *, fe_t *, uint32_t);
+void fe_pow_chain_223(fe_t *, fe_t *, fe_t *, fe_t *, fe_t *);
+void fe_inv(fe_t *, fe_t *);
+void fe_inv_var(fe_t *, fe_t *);
+void fe_inv_batch(fe_t *, fe_t *, size_t, int32_t);
+int32_t fe_sqrt(fe_t *, fe_t *);
+
+const SECP256K1 *secp256k1_init(void);
+void secp256k1_jac_set_pt(PTJ *, PT *);
+void secp256k1_jac_get_pt(PT *, PTJ *, int32_t);
+void secp256k1_jac_get_pt_batch(PT *, PTJ *, size_t, int32_t);
+void secp256k1_jac_double(PTJ *, PTJ *);
+void secp256k1_jac_add(PTJ *, PTJ *, PTJ *);
+void secp256k1_jac_add_affine(PTJ *, PTJ *, PT *);
+void secp256k1_point_doubling(PT *, PT *);
+void secp256k1_point_addition(PT *, PT *, PT *);
+void secp256k1_gen_table_init(const SECP256K1 *);
+void secp256k1_scalar_multiplication_jac(const SECP256K1 *, PTJ *, u256_t *);
+void secp256k1_scalar_multiplication(const SECP256K1 *, PT *, u256_t *);
+void secp256k1_scalar_multiplication_batch(const SECP256K1 *, PT *, u256_t *, size_t);
+size_t secp256k1_wnaf(int32_t *, u256_t *, uint32_t);
+void secp256k1_jac_odd_multiples(PTJ *, PTJ *, size_t);
+void secp256k1_jac_add_naf(PTJ *, PTJ *, int32_t);
+void secp256k1_jac_add_naf_affine(PTJ *, PT *, int32_t);
+void secp256k1_mul_shift_384(u256_t *, u256_t *, u256_t *);
+void secp256k1_scalar_split_lambda(const SECP256K1 *, u256_t *, int32_t *, u256_t *, int32_t *, u256_t *);
+void secp256k1_point_multiply(const SECP256K1 *, PT *, PT *, u256_t *);
+void secp256k1_dual_multiply_jac(const SECP256K1 *, PTJ *, u256_t *, PT *, u256_t *);
+int32_t secp256k1_self_check(const SECP256K1 *);
+
+void modinv_set_u256(modinv_signed_t *r, u256_t *a) // split a into MODINV_BITS bit limbs
+{
+    bnz_dlimb_t acc = 0;
+    uint32_t bits = 0;
+    size_t i, j = 0;
+
+    for (i = 0; i < MODINV_LIMBS; i++) {
+        while (bits < MODINV_BITS && j < U256_LIMBS) {
+            acc |= (bnz_dlimb_t)a->limbs[j++] << bits;
+            bits += BNZ_LIMB_BITS;
+        }
+        r->v[i] = (modinv_limb_t)(acc & MODINV_MASK);
+        acc >>= MODINV_BITS;
+        bits = bits > MODINV_BITS ? bits - MODINV_BITS : 0;
+    }
+}
+
+void modinv_get_u256(u256_t *r, modinv_signed_t *a) // join the limbs of a normalized a, 0 <= a < 2^256
+{
+    bnz_dlimb_t acc = 0;
+    uint32_t bits = 0;
+    size_t i = 0, j;
+
+    for (j = 0; j < U256_LIMBS; j++) {
+        while (bits < BNZ_LIMB_BITS && i < MODINV_LIMBS) {
+            acc |= (bnz_dlimb_t)(modinv_ulimb_t)a->v[i++] << bits;
+            bits += MODINV_BITS;
+        }
+        r->limbs[j] = (bnz_limb_t)acc;
+        acc >>= BNZ_LIMB_BITS;
+        bits = bits > BNZ_LIMB_BITS ? bits - BNZ_LIMB_BITS : 0;
+    }
+}
+
+modinv_limb_t modinv_divsteps(modinv_limb_t zeta, modinv_ulimb_t f0, modinv_ulimb_t g0, modinv_trans_t *t) // MODINV_STEPS branchless divsteps on the low bits of f and g, zeta = -(delta + 1/2)
+{
+    modinv_ulimb_t u = (modinv_ulimb_t)1 << (MODINV_BITS - MODINV_STEPS), v = 0, q = 0, r = u; // start scaled so the matrix ends scaled by 2^MODINV_BITS
+    modinv_ulimb_t f = f0, g = g0, x, y, z, mask1, mask2;
+    uint32_t i;
+
+    for (i = 0; i < MODINV_STEPS; i++) { // f is odd throughout
+        mask1 = (modinv_ulimb_t)MODINV_SIGN(zeta); // all ones when delta > 0
+        mask2 = -(g & 1); // all ones when g is odd
+        x = (f ^ mask1) - mask1; // -f, -u, -v when delta > 0
+        y = (u ^ mask1) - mask1;
+        z = (v ^ mask1) - mask1;
+        g += x & mask2; // g - f or g + f when g is odd
+        q += y & mask2;
+        r += z & mask2;
+        mask1 &= mask2; // swap when delta > 0 and g is odd
+        zeta = (zeta ^ (modinv_limb_t)mask1) - 1;
+        f += g & mask1; // f + (g - f) = g
+        u += q & mask1;
+        v += r & mask1;
+        g >>= 1;
+        u <<= 1;
+        v <<= 1;
+    }
+
+    t->u = (modinv_limb_t)u;
+    t->v = (modinv_limb_t)v;
+    t->q = (modinv_limb_t)q;
+    t->r = (modinv_limb_t)r;
+    return zeta;
+}
+
+uint32_t modinv_ctz(modinv_ulimb_t x) // number of trailing zero bits of x != 0
+{
+#if defined(__GNUC__)
+    return sizeof(x) > 4 ? (uint32_t)__builtin_ctzll(x) : (uint32_t)__builtin_ctz((uint32_t)x);
+#else
+    uint32_t n = 0;
+    while (!(x & 1)) {
+        x >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+modinv_limb_t modinv_divsteps_var(modinv_limb_t eta, modinv_ulimb_t f0, modinv_ulimb_t g0, modinv_trans_t *t) // MODINV_BITS divsteps with branches, skipping runs of even g at once, eta = -delta
+{
+    modinv_ulimb_t u = 1, v = 0, q = 0, r = 1, f = f0, g = g0, tmp;
+    uint32_t i = MODINV_BITS, zeros;
+
+    for (;;) {
+        zeros = modinv_ctz(g | ((modinv_ulimb_t)-1 << i)); // stop at the step budget
+        g >>= zeros;
+        u <<= zeros;
+        v <<= zeros;
+        eta -= (modinv_limb_t)zeros;
+        i -= zeros;
+        if (i == 0) break;
+        if (eta < 0) { // delta > 0, (f, g) = (g, -f)
+            eta = -eta;
+            tmp = f; f = g; g = -tmp;
+            tmp = u; u = q; q = -tmp;
+            tmp = v; v = r; r = -tmp;
+        }
+        g += f; // both odd, g is now even
+        q += u;
+        r += v;
+    }
+
+    t->u = (modinv_limb_t)u;
+    t->v = (modinv_limb_t)v;
+    t->q = (modinv_limb_t)q;
+    t->r = (modinv_limb_t)r;
+    return eta;
+}
+
+void modinv_update_de(modinv_signed_t *d, modinv_signed_t *e, modinv_trans_t *t, const modinv_mod_t *mod) // (d, e) = t * (d, e) / 2^MODINV_BITS mod m, keeping both in (-2m, m)
+{
+    modinv_limb_t md, me, sd, se, di, ei;
+    modinv_dlimb_t cd, ce;
+    size_t i;
+
+    sd = MODINV_SIGN(d->v[MODINV_LIMBS - 1]);
+    se = MODINV_SIGN(e->v[MODINV_LIMBS - 1]);
+    md = (t->u & sd) + (t->v & se); // add m for each negative input so the results stay above -2m
+    me = (t->q & sd) + (t->r & se);
+
+    di = d->v[0];
+    ei = e->v[0];
+    cd = (modinv_dlimb_t)t->u * di + (modinv_dlimb_t)t->v * ei;
+    ce = (modinv_dlimb_t)t->q * di + (modinv_dlimb_t)t->r * ei;
+    md -= (modinv_limb_t)((mod->m_inv * (modinv_ulimb_t)cd + (modinv_ulimb_t)md) & MODINV_MASK); // make the low MODINV_BITS bits cancel
+    me -= (modinv_limb_t)((mod->m_inv * (modinv_ulimb_t)ce + (modinv_ulimb_t)me) & MODINV_MASK);
+    cd += (modinv_dlimb_t)mod->m.v[0] * md;
+    ce += (modinv_dlimb_t)mod->m.v[0] * me;
+    cd >>= MODINV_BITS;
+    ce >>= MODINV_BITS;
+
+    for (i = 1; i < MODINV_LIMBS; i++) {
+        di = d->v[i];
+        ei = e->v[i];
+        cd += (modinv_dlimb_t)t->u * di + (modinv_dlimb_t)t->v * ei;
+        ce += (modinv_dlimb_t)t->q * di + (modinv_dlimb_t)t->r * ei;
+        if (mod->m.v[i]) {
+            cd += (modinv_dlimb_t)mod->m.v[i] * md;
+            ce += (modinv_dlimb_t)mod->m.v[i] * me;
+        }
+        d->v[i - 1] = (modinv_limb_t)((modinv_ulimb_t)cd & MODINV_MASK);
+        e->v[i - 1] = (modinv_limb_t)((modinv_ulimb_t)ce & MODINV_MASK);
+        cd >>= MODINV_BITS;
+        ce >>= MODINV_BITS;
+    }
+    d->v[MODINV_LIMBS - 1] = (modinv_limb_t)cd;
+    e->v[MODINV_LIMBS - 1] = (modinv_limb_t)ce;
+}
+
+void modinv_update_fg(modinv_signed_t *f, modinv_signed_t *g, modinv_trans_t *t, size_t len) // (f, g) = t * (f, g) / 2^MODINV_BITS over the low len limbs, the division is exact
+{
+    modinv_limb_t fi, gi;
+    modinv_dlimb_t cf, cg;
+    size_t i;
+
+    fi = f->v[0];
+    gi = g->v[0];
+    cf = (modinv_dlimb_t)t->u * fi + (modinv_dlimb_t)t->v * gi;
+    cg = (modinv_dlimb_t)t->q * fi + (modinv_dlimb_t)t->r * gi;
+    cf >>= MODINV_BITS;
+    cg >>= MODINV_BITS;
+
+    for (i = 1; i < len; i++) {
+        fi = f->v[i];
+        gi = g->v[i];
+        cf += (modinv_dlimb_t)t->u * fi + (modinv_dlimb_t)t->v * gi;
+        cg += (modinv_dlimb_t)t->q * fi + (modinv_dlimb_t)t->r * gi;
+        f->v[i - 1] = (modinv_limb_t)((modinv_ulimb_t)cf & MODINV_MASK);
+        g->v[i - 1] = (modinv_limb_t)((modinv_ulimb_t)cg & MODINV_MASK);
+        cf >>= MODINV_BITS;
+        cg >>= MODINV_BITS;
+    }
+    f->v[len - 1] = (modinv_limb_t)cf;
+    g->v[len - 1] = (modinv_limb_t)cg;
+}
+
+void modinv_normalize(modinv_signed_t *r, modinv_limb_t sign, const modinv_mod_t *mod) // r = r mod m in [0, m) for r in (-2m, m), negated first when sign < 0
+{
+    modinv_limb_t cond;
+    size_t i;
+
+    cond = MODINV_SIGN(r->v[MODINV_LIMBS - 1]); // r < 0, add m once to bring it into (-m, m)
+    for (i = 0; i < MODINV_LIMBS; i++) r->v[i] += mod->m.v[i] & cond;
+    cond = MODINV_SIGN(sign);
+    for (i = 0; i < MODINV_LIMBS; i++) r->v[i] = (r->v[i] ^ cond) - cond;
+    for (i = 0; i + 1 < MODINV_LIMBS; i++) { // carry into the top limb, which carries the sign
+        r->v[i + 1] += r->v[i] >> MODINV_BITS;
+        r->v[i] &= (modinv_limb_t)MODINV_MASK;
+    }
+
+    cond = MODINV_SIGN(r->v[MODINV_LIMBS - 1]); // r < 0 again, one more m brings it into [0, m)
+    for (i = 0; i < MODINV_LIMBS; i++) r->v[i] += mod->m.v[i] & cond;
+    for (i = 0; i + 1 < MODINV_LIMBS; i++) {
+        r->v[i + 1] += r->v[i] >> MODINV_BITS;
+        r->v[i] &= (modinv_limb_t)MODINV_MASK;
+    }
+}
+
+void modinv(u256_t *r, u256_t *a, const modinv_mod_t *mod) // r = 1 / a mod m by bernstein-yang safegcd in constant time, 0 <= a < m, r = 0 for a = 0
+{
+    modinv_signed_t d, e, f, g;
+    modinv_trans_t t;
+    modinv_limb_t zeta = -1; // delta = 1/2
+    size_t i;
+
+    memset(&d, 0, sizeof(d)); // invariants: d * a = f, e * a = g (mod m)
+    memset(&e, 0, sizeof(e));
+    e.v[0] = 1;
+    f = mod->m;
+    modinv_set_u256(&g, a);
+
+    for (i = 0; i < MODINV_ROUNDS; i++) {
+        zeta = modinv_divsteps(zeta, (modinv_ulimb_t)f.v[0], (modinv_ulimb_t)g.v[0], &t);
+        modinv_update_de(&d, &e, &t, mod);
+        modinv_update_fg(&f, &g, &t, MODINV_LIMBS);
+    }
+
+    modinv_normalize(&d, f.v[MODINV_LIMBS - 1], mod); // g = 0 and f = +-gcd = +-1
+    modinv_get_u256(r, &d);
+}
+
+void modinv_var(u256_t *r, u256_t *a, const modinv_mod_t *mod) // r = 1 / a mod m by safegcd in variable time, stopping as soon as g = 0 and shortening f and g as they shrink
+{
+    modinv_signed_t d, e, f, g;
+    modinv_trans_t t;
+    modinv_limb_t eta = -1, fn, gn, cond; // delta = 1
+    size_t i, len = MODINV_LIMBS;
+
+    memset(&d, 0, sizeof(d));
+    memset(&e, 0, sizeof(e));
+    e.v[0] = 1;
+    f = mod->m;
+    modinv_set_u256(&g, a);
+
+    for (;;) {
+        eta = modinv_divsteps_var(eta, (modinv_ulimb_t)f.v[0], (modinv_ulimb_t)g.v[0], &t);
+        modinv_update_de(&d, &e, &t, mod);
+        modinv_update_fg(&f, &g, &t, len);
+
+        if (g.v[0] == 0) {
+            cond = 0;
+            for (i = 1; i < len; i++) cond |= g.v[i];
+            if (cond == 0) break;
+        }
+
+        fn = f.v[len - 1];
+        gn = g.v[len - 1];
+        cond = len > 2 ? 0 : 1;
+        cond |= fn ^ MODINV_SIGN(fn);
+        cond |= gn ^ MODINV_SIGN(gn);
+        if (cond == 0) { // both top limbs are 0 or -1, fold them into the limb below
+            f.v[len - 2] |= (modinv_limb_t)((modinv_ulimb_t)fn << MODINV_BITS);
+            g.v[len - 2] |= (modinv_limb_t)((modinv_ulimb_t)gn << MODINV_BITS);
+            len--;
+        }
+    }
+
+    modinv_normalize(&d, f.v[len - 1], mod);
+    modinv_get_u256(r, &d);
+}
+
+void fe_set_u256(fe_t *r, u256_t *a) // set r to a, which needs no reduction to be a valid field element
+{
+    memcpy(r->limbs, a->limbs, sizeof(r->limbs));
+}
+
+void fe_get_u256(u256_t *r, fe_t *a) // set r to a reduced below p
+{
+    fe_t t;
+    fe_normalize(&t, a);
+    memcpy(r->limbs, t.limbs, sizeof(r->limbs));
+}
+
+void fe_set_ui32(fe_t *r, uint32_t a) // set r to a
+{
+    memset(r->limbs, 0, sizeof(r->limbs));
+    r->limbs[0] = a;
+}
+
+void fe_normalize(fe_t *r, fe_t *a) // r = a mod p, the unique representative below p, a < 2^256 < 2p so one subtraction is enough
+{
+    fe_t t;
+    if (add_limb_arr(t.limbs, a->limbs, (bnz_limb_t *)fe_c.limbs, U256_LIMBS)) { // a + 2^256 - p carries out exactly when a >= p
+        *r = t;
+    } else {
+        *r = *a;
+    }
+}
+
+int32_t fe_is_zero(fe_t *a) // return 1 if a == 0 mod p, return 0 otherwise
+{
+    fe_t t;
+    size_t i;
+    bnz_limb_t acc = 0;
+    fe_normalize(&t, a);
+    for (i = 0; i < U256_LIMBS; i++) acc |= t.limbs[i];
+    return acc == 0;
+}
+
+int32_t fe_equal(fe_t *a, fe_t *b) // return 1 if a == b mod p, return 0 otherwise
+{
+    fe_t t;
+    fe_sub(&t, a, b);
+    return fe_is_zero(&t);
+}
+
+void fe_fold_limb_arr(bnz_limb_t *u, bnz_limb_t *hi, size_t hi_len) // u += hi * 2^256 mod p over U256_LIMBS + 2 limbs, with hi_len <= U256_LIMBS, multiplying by 2^32 + 977 instead of dividing by p
+{
+    size_t j;
+    bnz_limb_t c;
+    for (j = 0; j < FE_C_LIMBS; j++) {
+        c = addmul_1_limb_arr(u + j, hi, hi_len, fe_c.limbs[j]);
+        add_1_limb_arr(u + j + hi_len, u + j + hi_len, U256_LIMBS + 2 - j - hi_len, c);
+    }
+}
+
+void fe_reduce(fe_t *r, bnz_limb_t *t) // r = t mod p below 2^256 for a 2 * U256_LIMBS limb t, folding the high half down until it is gone
+{
+#if BNZ_LIMB_BITS == 64
+    bnz_dlimb_t acc = 0;
+    size_t i;
+
+    for (i = 0; i < U256_LIMBS; i++) { // 2^256 = 0x1000003D1 fits one limb, fold the high half in one pass
+        acc += (bnz_dlimb_t)t[U256_LIMBS + i] * fe_c.limbs[0] + t[i];
+        r->limbs[i] = (bnz_limb_t)acc;
+        acc >>= BNZ_LIMB_BITS;
+    }
+    while (acc) { // below 2^34, then 1 at most once more
+        acc *= fe_c.limbs[0];
+        for (i = 0; i < U256_LIMBS; i++) {
+            acc += r->limbs[i];
+            r->limbs[i] = (bnz_limb_t)acc;
+            acc >>= BNZ_LIMB_BITS;
+        }
+    }
+#else
+    bnz_limb_t u[U256_LIMBS + 2], h[2];
+
+    memcpy(u, t, U256_LIMBS * sizeof(bnz_limb_t));
+    u[U256_LIMBS] = 0;
+    u[U256_LIMBS + 1] = 0;
+    fe_fold_limb_arr(u, t + U256_LIMBS, U256_LIMBS); // below 2^290
+
+    while (u[U256_LIMBS] | u[U256_LIMBS + 1]) { // below 2^256 + 2^68 after one more fold, and below 2^256 after at most two
+        h[0] = u[U256_LIMBS];
+        h[1] = u[U256_LIMBS + 1];
+        u[U256_LIMBS] = 0;
+        u[U256_LIMBS + 1] = 0;
+        fe_fold_limb_arr(u, h, 2);
+    }
+    memcpy(r->limbs, u, U256_LIMBS * sizeof(bnz_limb_t));
+#endif
+}
+
+void fe_add(fe_t *r, fe_t *a, fe_t *b) // r = a + b mod p below 2^256
+{
+    bnz_limb_t c = add_limb_arr(r->limbs, a->limbs, b->limbs, U256_LIMBS);
+    while (c) c = add_limb_arr(r->limbs, r->limbs, (bnz_limb_t *)fe_c.limbs, U256_LIMBS); // 2^256 = 2^32 + 977 mod p
+}
+
+void fe_sub(fe_t *r, fe_t *a, fe_t *b) // r = a - b mod p below 2^256
+{
+    bnz_limb_t c = sub_limb_arr(r->limbs, a->limbs, b->limbs, U256_LIMBS);
+    while (c) c = sub_limb_arr(r->limbs, r->limbs, (bnz_limb_t *)fe_c.limbs, U256_LIMBS); // a borrow added 2^256, take 2^32 + 977 back off
+}
+
+void fe_negate(fe_t *r, fe_t *a) // r = -a mod p
+{
+    fe_t p;
+    memset(p.limbs, 0, sizeof(p.limbs));
+    sub_limb_arr(p.limbs, p.limbs, (bnz_limb_t *)fe_c.limbs, U256_LIMBS); // p = 2^256 - (2^32 + 977)
+    fe_normalize(r, a);
+    sub_limb_arr(r->limbs, p.limbs, r->limbs, U256_LIMBS);
+}
+
+void fe_mul_ui32(fe_t *r, fe_t *a, uint32_t b) // r = a * b mod p below 2^256
+{
+    bnz_limb_t u[U256_LIMBS + 2], h[2];
+
+    memcpy(u, a->limbs, U256_LIMBS * sizeof(bnz_limb_t));
+    h[0] = mul_add_limb_arr(u, U256_LIMBS, b, 0);
+    h[1] = 0;
+    u[U256_LIMBS] = 0;
+    u[U256_LIMBS + 1] = 0;
+    fe_fold_limb_arr(u, h, 2);
+    if (u[U256_LIMBS]) { // at most one more wrap
+        h[0] = u[U256_LIMBS];
+        u[U256_LIMBS] = 0;
+        fe_fold_limb_arr(u, h, 2);
+    }
+    memcpy(r->limbs, u, U256_LIMBS * sizeof(bnz_limb_t));
+}
+
+void fe_mul(fe_t *r, fe_t *a, fe_t *b) // r = a * b mod p below 2^256, the schoolbook loops have fixed bounds so they unroll
+{
+    bnz_limb_t t[2 * U256_LIMBS];
+    bnz_dlimb_t acc;
+    size_t i, j;
+
+    for (i = 0; i < U256_LIMBS; i++) {
+        acc = 0;
+        for (j = 0; j < U256_LIMBS; j++) {
+            acc += (bnz_dlimb_t)a->limbs[i] * b->limbs[j] + (i ? t[i + j] : 0);
+            t[i + j] = (bnz_limb_t)acc;
+            acc >>= BNZ_LIMB_BITS;
+        }
+        t[i + U256_LIMBS] = (bnz_limb_t)acc;
+    }
+    fe_reduce(r, t);
+}
+
+void fe_sqr(fe_t *r, fe_t *a) // r = a^2 mod p below 2^256, each cross product computed once and doubled
+{
+    bnz_limb_t t[2 * U256_LIMBS] = {0};
+    bnz_dlimb_t acc;
+    size_t i, j;
+
+    for (i = 0; i < U256_LIMBS - 1; i++) {
+        acc = 0;
+        for (j = i + 1; j < U256_LIMBS; j++) {
+            acc += (bnz_dlimb_t)a->limbs[i] * a->limbs[j] + t[i + j];
+            t[i + j] = (bnz_limb_t)acc;
+            acc >>= BNZ_LIMB_BITS;
+        }
+        t[i + U256_LIMBS] = (bnz_limb_t)acc;
+    }
+
+    for (i = 2 * U256_LIMBS - 1; i > 0; i--) t[i] = (t[i] << 1) | (t[i - 1] >> (BNZ_LIMB_BITS - 1)); // double the cross products
+
+    acc = 0;
+    for (i = 0; i < U256_LIMBS; i++) { // add the squares on the diagonal
+        acc += (bnz_dlimb_t)a->limbs[i] * a->limbs[i] + t[2 * i];
+        t[2 * i] = (bnz_limb_t)acc;
+        acc >>= BNZ_LIMB_BITS;
+        acc += t[2 * i + 1];
+        t[2 * i + 1] = (bnz_limb_t)acc;
+        acc >>= BNZ_LIMB_BITS;
+    }
+    fe_reduce(r, t);
+}
+
+void fe_sqr_n(fe_t *r, fe_t *a, uint32_t n) // r = a^(2^n) mod p, n >= 1
+{
+    uint32_t i;
+    fe_sqr(r, a);
+    for (i = 1; i < n; i++) fe_sqr(r, r);
+}
+
+void fe_pow_chain_223(fe_t *x223, fe_t *x22, fe_t *x2, fe_t *x3, fe_t *a) // x_k = a^(2^k - 1) for k = 2, 3, 22 and 223, the run of ones in the exponent of fe_sqrt
+{
+    fe_t x6, x9, x11, x44, x88, x176, x220;
+
+    fe_sqr(x2, a);
+    fe_mul(x2, x2, a);
+    fe_sqr(x3, x2);
+    fe_mul(x3, x3, a);
+    fe_sqr_n(&x6, x3, 3);
+    fe_mul(&x6, &x6, x3);
+    fe_sqr_n(&x9, &x6, 3);
+    fe_mul(&x9, &x9, x3);
+    fe_sqr_n(&x11, &x9, 2);
+    fe_mul(&x11, &x11, x2);
+    fe_sqr_n(x22, &x11, 11);
+    fe_mul(x22, x22, &x11);
+    fe_sqr_n(&x44, x22, 22);
+    fe_mul(&x44, &x44, x22);
+    fe_sqr_n(&x88, &x44, 44);
+    fe_mul(&x88, &x88, &x44);
+    fe_sqr_n(&x176, &x88, 88);
+    fe_mul(&x176, &x176, &x88);
+    fe_sqr_n(&x220, &x176, 44);
+    fe_mul(&x220, &x220, &x44);
+    fe_sqr_n(x223, &x220, 3);
+    fe_mul(x223, x223, x3);
+}
+
+void fe_inv(fe_t *r, fe_t *a) // r = 1 / a mod p in constant time for secret a, r = 0 for a = 0
+{
+    u256_t t;
+    fe_get_u256(&t, a);
+    modinv(&t, &t, &secp256k1_modinv_p);
+    fe_set_u256(r, &t);
+}
+
+void fe_inv_var(fe_t *r, fe_t *a) // r = 1 / a mod p in variable time, only for public a
+{
+    u256_t t;
+    fe_get_u256(&t, a);
+    modinv_var(&t, &t, &secp256k1_modinv_p);
+    fe_set_u256(r, &t);
+}
+
+void fe_inv_batch(fe_t *r, fe_t *a, size_t n, int32_t var) // r[i] = 1 / a[i] mod p for n elements with one inversion and 3(n - 1) multiplications by montgomery's trick, r must not overlap a, zero elements give zero, var selects the variable time inversion for public a
+{
+    fe_t acc, t;
+    size_t i;
+
+    fe_set_ui32(&acc, 1);
+    for (i = 0; i < n; i++) { // r[i] = product of the nonzero a[j] for j < i
+        r[i] = acc;
+        if (!fe_is_zero(&a[i])) fe_mul(&acc, &acc, &a[i]);
+    }
+
+    if (var) {
+        fe_inv_var(&acc, &acc);
+    } else {
+        fe_inv(&acc, &acc);
+    }
+
+    for (i = n; i > 0; i--) { // peel one element off the inverted product at a time
+        if (fe_is_zero(&a[i - 1])) {
+            fe_set_ui32(&r[i - 1], 0);
+            continue;
+        }
+        fe_mul(&t, &acc, &r[i - 1]);
+        fe_mul(&acc, &acc, &a[i - 1]);
+        r[i - 1] = t;
+    }
+}
+
+int32_t fe_sqrt(fe_t *r, fe_t *a) // r = a^((p + 1) / 4) mod p by a fixed addition chain, return 1 if r is a square root of a, return 0 if a is not a square
+{
+    fe_t x2, x3, x22, x223, t, b = *a;
+
+    // (p + 1) / 4 is a block of 223 ones, a zero, 22 ones, four zeros, 2 ones and two zeros
+    fe_pow_chain_223(&x223, &x22, &x2, &x3, &b);
+    fe_sqr_n(&t, &x223, 23);
+    fe_mul(&t, &t, &x22);
+    fe_sqr_n(&t, &t, 6);
+    fe_mul(&t, &t, &x2);
+    fe_sqr_n(r, &t, 2);
+
+    fe_sqr(&t, r);
+    return fe_equal(&t, &b);
+}
+
+const SECP256K1 *secp256k1_init() // return the shared secp256k1 curve, filling its fixed base table on first use
+{
+    secp256k1_gen_table_init(&secp256k1_ctx);
+    return &secp256k1_ctx;
+}
+
+void secp256k1_jac_set_pt(PTJ *r, PT *a) // r = a with z = 1, the (0, 0) sentinel becomes the point at infinity
+{
+    fe_set_u256(&r->x, &a->x);
+    fe_set_u256(&r->y, &a->y);
+    fe_set_ui32(&r->z, 1);
+    r->infinity = fe_is_zero(&r->x) && fe_is_zero(&r->y);
+}
 
-    bnz_align(&aa, &bb);
-    bnz_resize(&tmp, aa.size * 2, 0);
+void secp256k1_jac_get_pt(PT *r, PTJ *a, int32_t var) // r = a in affine coordinates with a single inversion, the point at infinity becomes (0, 0), var selects the variable time inversion when a is public
+{
+    fe_t zi, zi2, t;
 
-    if (a->sign) { // -a
-        if (b->sign) { // -a, -b
-            tmp.sign = 0;
-        } else { // -a, +b
-            tmp.sign = 1;
-        }
-    } else { // +a
-        if (b->sign) { // +a, -b
-            tmp.sign = 1;
-        } else { // +a, +b
-            tmp.sign = 0;
-        }
+    if (a->infinity) {
+        u256_set_ui32(&r->x, 0);
+        u256_set_ui32(&r->y, 0);
+        return;
     }
 
-    for (i = 0; i < aa.size; i++) {
-        if (bb.digits[i] == 0) {
-            tmp.digits[i + aa.size] = 0;
-        } else {
-            k = 0;
-            for (j = 0; j < aa.size; j++) {
-                m = aa.digits[j] * bb.digits[i];
-                t[0] = (m & 255) + k;
-                t[1] = (m >> 8) & 255;
-                if (t[0] < k) t[1]++;
-                t[0] += tmp.digits[j + i];
-                if (t[0] < tmp.digits[j + i]) t[1]++;
-                tmp.digits[j + i] = t[0];
-                k = t[1];
-            }    
-            tmp.digits[i + aa.size] = k;
-        }
+    if (var) {
+        fe_inv_var(&zi, &a->z);
+    } else {
+        fe_inv(&zi, &a->z);
     }
-
-    bnz_trim(&tmp);
-
-    bnz_set_bnz(c, &tmp);
-
-    bnz_free(&tmp);
-    bnz_free(&aa);
-    bnz_free(&bb);
+    fe_sqr(&zi2, &zi);
+    fe_mul(&t, &a->x, &zi2);
+    fe_get_u256(&r->x, &t); // x / z^2
+    fe_mul(&zi2, &zi2, &zi);
+    fe_mul(&t, &a->y, &zi2);
+    fe_get_u256(&r->y, &t); // y / z^3
 }
 
-void bnz_division_signs(bnz_t *q, bnz_t *r, bnz_t *a, bnz_t *b) // process signs of q and r in a / b
+void secp256k1_jac_get_pt_batch(PT *r, PTJ *a, size_t n, int32_t var) // r[i] = a[i] in affine coordinates for n points, one inversion per SECP256K1_BATCH points, var as in secp256k1_jac_get_pt
 {
-    if (a->sign) { // -a
-        if (b->sign) { // -a, -b
-            q->sign = 0; // +q
-            r->sign = 1; // -r
-        } else { // -a, +b
-            q->sign = 1; // -q
-            r->sign = 1; // -r
+    fe_t z[SECP256K1_BATCH], zi[SECP256K1_BATCH], zi2, t;
+    size_t i, j, len;
+
+    for (i = 0; i < n; i += len) {
+        len = n - i < SECP256K1_BATCH ? n - i : SECP256K1_BATCH;
+        for (j = 0; j < len; j++) {
+            if (a[i + j].infinity) {
+                fe_set_ui32(&z[j], 0); // skipped by the batch inversion
+            } else {
+                z[j] = a[i + j].z;
+            }
         }
-    } else { // +a
-        if (b->sign) { // +a, -b
-            q->sign = 1; // -q
-            r->sign = 0; // +r
-        } else { // +a, +b
-            q->sign = 0; // +q
-            r->sign = 0; // +r
+        fe_inv_batch(zi, z, len, var);
+        for (j = 0; j < len; j++) {
+            if (a[i + j].infinity) {
+                u256_set_ui32(&r[i + j].x, 0);
+                u256_set_ui32(&r[i + j].y, 0);
+                continue;
+            }
+            fe_sqr(&zi2, &zi[j]);
+            fe_mul(&t, &a[i + j].x, &zi2);
+            fe_get_u256(&r[i + j].x, &t);
+            fe_mul(&zi2, &zi2, &zi[j]);
+            fe_mul(&t, &a[i + j].y, &zi2);
+            fe_get_u256(&r[i + j].y, &t);
         }
     }
 }
 
-void bnz_divide_bnz(bnz_t *q, bnz_t *r, bnz_t *a, bnz_t *b) // get q and r of a / b, taking account of signs, invoking bnz_division
+void secp256k1_jac_double(PTJ *r, PTJ *p) // r = 2p, r may alias p, with the a = 0 doubling formula of secp256k1 (2M + 5S)
 {
-    int32_t cmp;
-
-    bnz_t aa, bb;
+    fe_t a, b, c, d, e, f;
 
-    bnz_init(&aa);
-    bnz_init(&bb);
+    if (p->infinity || fe_is_zero(&p->y)) { // no point of order 2 lies on the curve, y = 0 is only reached through infinity
+        r->infinity = 1;
+        return;
+    }
 
-    bnz_set_bnz(&aa, a);
-    bnz_set_bnz(&bb, b);
-    bnz_trim(&aa);
-    bnz_trim(&bb);
+    fe_sqr(&a, &p->x); // a = x^2
+    fe_sqr(&b, &p->y); // b = y^2
+    fe_sqr(&c, &b); // c = y^4
+    fe_add(&d, &p->x, &b);
+    fe_sqr(&d, &d);
+    fe_sub(&d, &d, &a);
+    fe_sub(&d, &d, &c);
+    fe_add(&d, &d, &d); // d = 2((x + y^2)^2 - x^2 - y^4) = 4xy^2
+    fe_mul_ui32(&e, &a, 3); // e = 3x^2
+    fe_sqr(&f, &e); // f = e^2
+
+    fe_mul(&r->z, &p->y, &p->z);
+    fe_add(&r->z, &r->z, &r->z); // z3 = 2yz, before y is overwritten
+    fe_sub(&r->x, &f, &d);
+    fe_sub(&r->x, &r->x, &d); // x3 = f - 2d
+    fe_sub(&d, &d, &r->x);
+    fe_mul(&d, &e, &d);
+    fe_mul_ui32(&c, &c, 8);
+    fe_sub(&r->y, &d, &c); // y3 = e(d - x3) - 8c
+    r->infinity = 0;
+}
 
-    aa.sign = 0;
-    bb.sign = 0;
+void secp256k1_jac_add(PTJ *r, PTJ *p, PTJ *q) // r = p + q, r may alias p or q, falling back to doubling for p = q (12M + 4S)
+{
+    fe_t z1z1, z2z2, u1, u2, s1, s2, h, hh, hhh, rr, v;
 
-    if (bnz_is_zero(&bb)) { // divide by 0
-        printf("div 0 error\n");
-        bnz_set_i32(q, 0);
-        bnz_set_i32(r, 0);
+    if (p->infinity) {
+        *r = *q;
         return;
     }
-
-    cmp = bnz_cmp_bnz(&aa, &bb);
-
-    if (cmp == 0) { // |aa| = |bb|
-        bnz_set_i32(q, 1);
-        bnz_set_i32(r, 0);
-        bnz_division_signs(q, r, a, b);
-        bnz_free(&aa);
-        bnz_free(&bb);
+    if (q->infinity) {
+        *r = *p;
         return;
     }
 
-    if (cmp == -1) { // |aa| < |bb|
-        bnz_set_i32(q, 0);
-        bnz_set_bnz(r, &aa);
-        bnz_division_signs(q, r, a, b);
-        bnz_free(&aa);
-        bnz_free(&bb);
+    fe_sqr(&z1z1, &p->z);
+    fe_sqr(&z2z2, &q->z);
+    fe_mul(&u1, &p->x, &z2z2); // u1 = x1 z2^2
+    fe_mul(&u2, &q->x, &z1z1); // u2 = x2 z1^2
+    fe_mul(&s1, &p->y, &q->z);
+    fe_mul(&s1, &s1, &z2z2); // s1 = y1 z2^3
+    fe_mul(&s2, &q->y, &p->z);
+    fe_mul(&s2, &s2, &z1z1); // s2 = y2 z1^3
+    fe_sub(&h, &u2, &u1);
+    fe_sub(&rr, &s2, &s1);
+
+    if (fe_is_zero(&h)) { // same x
+        if (fe_is_zero(&rr)) {
+            secp256k1_jac_double(r, p);
+        } else { // q = -p
+            r->infinity = 1;
+        }
         return;
     }
 
-    bnz_division(q, r, &aa, &bb); // |aa| > |bb|
-    bnz_division_signs(q, r, a, b);
-
-    bnz_free(&aa);
-    bnz_free(&bb);   
+    fe_sqr(&hh, &h);
+    fe_mul(&hhh, &hh, &h);
+    fe_mul(&v, &u1, &hh); // v = u1 h^2
+
+    fe_mul(&r->z, &p->z, &q->z);
+    fe_mul(&r->z, &r->z, &h); // z3 = z1 z2 h
+    fe_sqr(&r->x, &rr);
+    fe_sub(&r->x, &r->x, &hhh);
+    fe_sub(&r->x, &r->x, &v);
+    fe_sub(&r->x, &r->x, &v); // x3 = r^2 - h^3 - 2v
+    fe_sub(&v, &v, &r->x);
+    fe_mul(&v, &rr, &v);
+    fe_mul(&s1, &s1, &hhh);
+    fe_sub(&r->y, &v, &s1); // y3 = r(v - x3) - s1 h^3
+    r->infinity = 0;
 }
 
-void bnz_division(bnz_t *q, bnz_t *r, bnz_t *a, bnz_t *b) // get q and r of |a| / |b|
+void secp256k1_jac_add_affine(PTJ *r, PTJ *p, PT *q) // r = p + q for an affine q, r may alias p, saving the products with z2 = 1 (8M + 3S)
 {
-    uint8_t *an = NULL, *bn = NULL, tmp = b->digits[b->size - 1];
-    uint16_t q_hat, r_hat, p, base = 256;
-    int32_t sh = 0, i, j, t, k, cmp;
-
-    bnz_resize(q, a->size - b->size + 1, 0);
-    bnz_resize(r, b->size, 0);
+    fe_t qx, qy, z1z1, u2, s2, h, hh, hhh, rr, v;
 
-    while (tmp < 128) { // measure left shift required to ensure that the highest bit of bn->digits[bn->size - 1] is set
-        sh++;
-        tmp <<= 1;
-    }
+    fe_set_u256(&qx, &q->x);
+    fe_set_u256(&qy, &q->y);
 
-    // an
-    if (!(an = init_uint8_array(2 * (a->size + 1)))) return;
-    an[a->size] = a->digits[a->size - 1] >> 8 - sh;
-    for (i = a->size - 1; i > 0; i--) {
-        an[i] = (a->digits[i] << sh) | (a->digits[i-1] >> 8 - sh);
+    if (fe_is_zero(&qx) && fe_is_zero(&qy)) { // q is the point at infinity
+        *r = *p;
+        return;
     }
-    an[0] = a->digits[0] << sh;
-
-    // bn
-    if (!(bn = init_uint8_array(2 * b->size))) return;
-    for (i = b->size - 1; i > 0; i--) {
-        bn[i] = (b->digits[i] << sh) | (b->digits[i - 1] >> 8 - sh);
+    if (p->infinity) {
+        r->x = qx;
+        r->y = qy;
+        fe_set_ui32(&r->z, 1);
+        r->infinity = 0;
+        return;
     }
-    bn[0] = b->digits[0] << sh;
-
-    // main loop
-    for (j = a->size - b->size; j >= 0; j--) {
-        q_hat = ((an[j + b->size] * base) + an[j + b->size - 1]) / bn[b->size - 1];
-        r_hat = ((an[j + b->size] * base) + an[j + b->size - 1]) - (q_hat * bn[b->size - 1]);
-
-        // q_hat adjustment, maximum 2 iterations
-        if (q_hat >= base || q_hat * bn[b->size - 2] > (base * r_hat) + an[j + b->size - 2]) { // first iteration
-            q_hat -= 1;
-            r_hat += bn[b->size - 1];
-            if (r_hat < base) { // second iteration
-                if (q_hat >= base || q_hat * bn[b->size - 2] > (base * r_hat) + an[j + b->size - 2]) {
-                    q_hat -= 1;
-                    r_hat += bn[b->size - 1];
-                }
-            }
-        }
 
-        k = 0;
-        for (i = 0; i < b->size; i++) {
-            p = q_hat * bn[i];
-            t = an[i + j] - k - (p & 255);
-            an[i + j] = t;
-            k = (p >> 8) - (t >> 8);
-        }
-        t = an[j + b->size] - k;
-        an[j + b->size] = t;
-
-        q->digits[j] = q_hat;
-
-        if (t < 0) {
-            k = 0;
-            q->digits[j] = q->digits[j] - 1;
-            for (i = 0; i < b->size; i++) {
-                t = an[i + j] + bn[i] + k;
-                an[i + j] = t;
-                k = t >> 8;
-            }
-            an[j + b->size] = an[j + b->size] + k;
+    fe_sqr(&z1z1, &p->z);
+    fe_mul(&u2, &qx, &z1z1); // u2 = x2 z1^2
+    fe_mul(&s2, &qy, &p->z);
+    fe_mul(&s2, &s2, &z1z1); // s2 = y2 z1^3
+    fe_sub(&h, &u2, &p->x);
+    fe_sub(&rr, &s2, &p->y);
+
+    if (fe_is_zero(&h)) { // same x
+        if (fe_is_zero(&rr)) {
+            secp256k1_jac_double(r, p);
+        } else { // q = -p
+            r->infinity = 1;
         }
+        return;
     }
 
-    for (i = 0; i < b->size; i++) {
-        r->digits[i] = (an[i] >> sh) | (an[i + 1] << 8 - sh);
-    }
+    fe_sqr(&hh, &h);
+    fe_mul(&hhh, &hh, &h);
+    fe_mul(&v, &p->x, &hh); // v = x1 h^2
+
+    fe_mul(&r->z, &p->z, &h); // z3 = z1 h
+    fe_mul(&s2, &p->y, &hhh); // y1 h^3, before y1 is overwritten
+    fe_sqr(&r->x, &rr);
+    fe_sub(&r->x, &r->x, &hhh);
+    fe_sub(&r->x, &r->x, &v);
+    fe_sub(&r->x, &r->x, &v); // x3 = r^2 - h^3 - 2v
+    fe_sub(&v, &v, &r->x);
+    fe_mul(&v, &rr, &v);
+    fe_sub(&r->y, &v, &s2); // y3 = r(v - x3) - y1 h^3
+    r->infinity = 0;
+}
 
-    bnz_trim(q);
-    bnz_trim(r);
+void secp256k1_point_doubling(PT *p, PT *r) // r = 2p on secp256k1, through jacobian coordinates and one inversion
+{
+    PTJ j;
 
-    free(an);
-    free(bn);
+    secp256k1_jac_set_pt(&j, p);
+    secp256k1_jac_double(&j, &j);
+    secp256k1_jac_get_pt(r, &j, 1);
 }
 
-void bnz_mod_bnz(bnz_t *c, bnz_t *a, bnz_t *b) // get c = a % b, invoking bnz_divide_bnz
+void secp256k1_point_addition(PT *p, PT *q, PT *r) // r = (p + q) mod secp256k1.p, through jacobian coordinates and one inversion
 {
-    bnz_t q, r;
+    PTJ j;
 
-    bnz_init(&q);
-    bnz_init(&r);
-    
-    bnz_divide_bnz(&q, &r, a, b);
-    bnz_trim(&r);
-    if (r.sign) bnz_add_bnz(&r, &r, b);
-    bnz_set_bnz(c, &r);
-    
-    bnz_free(&q);
-    bnz_free(&r);
+    secp256k1_jac_set_pt(&j, p);
+    secp256k1_jac_add_affine(&j, &j, q);
+    secp256k1_jac_get_pt(r, &j, 1);
 }
 
-void bnz_mod_pow(bnz_t *d, bnz_t *a, bnz_t *b, bnz_t *c) // get d = a^b mod c
+void secp256k1_gen_table_init(const SECP256K1 *secp256k1) // fill secp256k1->gen_table and secp256k1->gen_odd once per process, each row holds the multiples 1..15 of the base 16^i * G and is normalized with one batch inversion, threads arriving meanwhile wait for it
 {
-    bnz_t aa, bb;
+    size_t i, j;
+    int32_t empty = 0;
+    PTJ base, row[SECP256K1_GEN_POINTS], odd[SECP256K1_GEN_ODD];
+    fe_t x, beta;
 
-    bnz_init(&aa);
-    bnz_init(&bb);
+    if (SECP256K1_LOAD_ACQUIRE(&secp256k1_gen_table_state) == 2) return;
+    if (!SECP256K1_CAS(&secp256k1_gen_table_state, &empty, 1)) {
+        while (SECP256K1_LOAD_ACQUIRE(&secp256k1_gen_table_state) != 2) SECP256K1_PAUSE(); // another thread is filling it, the acquire load makes its table visible here
+        return;
+    }
 
-    bnz_set_i32(d, 1);
-    bnz_set_bnz(&aa, a);
-    bnz_set_bnz(&bb, b);
+    secp256k1_jac_set_pt(&base, (PT *)&secp256k1->G);
+    for (i = 0; i < SECP256K1_GEN_WINDOWS; i++) {
+        row[0] = base;
+        for (j = 1; j < SECP256K1_GEN_POINTS; j++) secp256k1_jac_add(&row[j], &row[j - 1], &base);
+        secp256k1_jac_get_pt_batch(secp256k1->gen_table[i], row, SECP256K1_GEN_POINTS, 1);
+        secp256k1_jac_add(&base, &row[SECP256K1_GEN_POINTS - 1], &base); // 16 times the previous base
+    }
 
-    while (bnz_cmp_i32(&bb, 0) == 1) {
-        if (bnz_bit_set(&bb, 0)) {
-            bnz_multiply_bnz(d, d, &aa);
-            bnz_mod_bnz(d, d, c);
-        }
-        bnz_multiply_bnz(&aa, &aa, &aa);
-        bnz_mod_bnz(&aa, &aa, c);
-        bnz_shift_r(&bb, 1);
+    secp256k1_jac_set_pt(&base, (PT *)&secp256k1->G);
+    secp256k1_jac_odd_multiples(odd, &base, SECP256K1_GEN_ODD);
+    secp256k1_jac_get_pt_batch(secp256k1->gen_odd[0], odd, SECP256K1_GEN_ODD, 1);
+    fe_set_u256(&beta, (u256_t *)&secp256k1->beta);
+    for (i = 0; i < SECP256K1_GEN_ODD; i++) { // lambda * (x, y) = (beta * x, y)
+        fe_set_u256(&x, &secp256k1->gen_odd[0][i].x);
+        fe_mul(&x, &x, &beta);
+        fe_get_u256(&secp256k1->gen_odd[1][i].x, &x);
+        secp256k1->gen_odd[1][i].y = secp256k1->gen_odd[0][i].y;
     }
 
-    bnz_free(&aa);
-    bnz_free(&bb);
+    SECP256K1_STORE_RELEASE(&secp256k1_gen_table_state, 2); // publish the table
 }
 
-void bnz_modular_multiplicative_inverse(bnz_t *c, bnz_t *a, bnz_t *b) // get c where (c * a) mod b = 1
+void secp256k1_scalar_multiplication_jac(const SECP256K1 *secp256k1, PTJ *r, u256_t *m) // r = secp256k1.G * m in jacobian coordinates, one table lookup and mixed addition per 4 bits of m and no doublings
 {
-    bnz_t q, rem, tmp1, t, new_t, r, new_r, tmp2;
-
-    bnz_init(&q);
-    bnz_init(&rem);
-    bnz_init(&t);
-    bnz_init(&new_t);
-    bnz_init(&r);
-    bnz_init(&new_r);
-    bnz_init(&tmp1);
-    bnz_init(&tmp2);
+    size_t i;
+    uint32_t d;
 
-    bnz_set_i32(&t, 0);
-    bnz_set_i32(&new_t, 1);
-    bnz_set_bnz(&r, b);
-    bnz_set_bnz(&new_r, a);
+    secp256k1_gen_table_init(secp256k1);
 
-    while (!bnz_is_zero(&new_r)) {
-        bnz_divide_bnz(&q, &rem, &r, &new_r);
-        bnz_set_bnz(&tmp1, &new_t);
-        bnz_multiply_bnz(&tmp2, &q, &tmp1);
-        bnz_subtract_bnz(&new_t, &t, &tmp2);
-        bnz_set_bnz(&t, &tmp1);
-        bnz_set_bnz(&tmp1, &new_r);
-        bnz_multiply_bnz(&tmp2, &q, &tmp1);
-        bnz_subtract_bnz(&new_r, &r, &tmp2);
-        bnz_set_bnz(&r, &tmp1);
-    }
+    r->infinity = 1;
 
-    if (bnz_cmp_i32(&r, 1) == 1) {
-        bnz_set_i32(c, 0);
-    } else {
-        if (t.sign) bnz_add_bnz(&t, &t, b);
-        bnz_set_bnz(c, &t);
+    for (i = 0; i < SECP256K1_GEN_WINDOWS; i++) {
+        d = u256_get_bits(m, i * SECP256K1_GEN_WINDOW, SECP256K1_GEN_WINDOW);
+        if (d) secp256k1_jac_add_affine(r, r, &secp256k1->gen_table[i][d - 1]);
     }
-
-    bnz_free(&q);
-    bnz_free(&rem);
-    bnz_free(&t);
-    bnz_free(&new_t);
-    bnz_free(&r);
-    bnz_free(&new_r);
-    bnz_free(&tmp1);
-    bnz_free(&tmp2);
 }
 
-/* SECP256K1 */
+void secp256k1_scalar_multiplication(const SECP256K1 *secp256k1, PT *r, u256_t *m) // r = (secp256k1.G * m) mod secp256k1.p, through the fixed base table with one inversion at the end
+{
+    PTJ acc;
 
-typedef struct {
-    bnz_t x;
-    bnz_t y;
-} PT;
+    secp256k1_scalar_multiplication_jac(secp256k1, &acc, m);
+    secp256k1_jac_get_pt(r, &acc, 0);
+}
 
-typedef struct {
-    bnz_t p;
-    bnz_t a;
-    bnz_t b;
-    PT G;
-    bnz_t n;
-    bnz_t h;
-} SECP256K1;
+void secp256k1_scalar_multiplication_batch(const SECP256K1 *secp256k1, PT *r, u256_t *m, size_t n) // r[i] = secp256k1.G * m[i] for n scalars, sharing one inversion per SECP256K1_BATCH points
+{
+    PTJ acc[SECP256K1_BATCH];
+    size_t i, j, len;
 
-SECP256K1 secp256k1_init(void);
-void secp256k1_free(SECP256K1);
-void secp256k1_point_doubling(SECP256K1, PT *, PT *);
-void secp256k1_point_addition(SECP256K1, PT *, PT *, PT *);
-void secp256k1_scalar_multiplication(SECP256K1, PT *, bnz_t *);
+    for (i = 0; i < n; i += len) {
+        len = n - i < SECP256K1_BATCH ? n - i : SECP256K1_BATCH;
+        for (j = 0; j < len; j++) secp256k1_scalar_multiplication_jac(secp256k1, &acc[j], &m[i + j]);
+        secp256k1_jac_get_pt_batch(r + i, acc, len, 0);
+    }
+}
 
-SECP256K1 secp256k1_init() // initiate secp256k1 curve
+size_t secp256k1_wnaf(int32_t *naf, u256_t *k, uint32_t w) // recode k into 257 width w naf digits, least significant first, each 0 or odd below 2^(w - 1) in magnitude with at least w - 1 zeros after every nonzero digit, return the number of digits up to the last nonzero one
 {
-    SECP256K1 secp256k1;
-
-    bnz_init(&secp256k1.p);
-    bnz_init(&secp256k1.a);
-    bnz_init(&secp256k1.b);
-    bnz_init(&secp256k1.G.x);
-    bnz_init(&secp256k1.G.y);
-    bnz_init(&secp256k1.n);
-    bnz_init(&secp256k1.h);
+    uint32_t bit = 0, carry = 0, now;
+    int32_t word;
+    size_t len = 0;
 
-    bnz_set_str(&secp256k1.p , "115792089237316195423570985008687907853269984665640564039457584007908834671663", 10); // prime
-    bnz_set_i32(&secp256k1.a, 0);
-    bnz_set_i32(&secp256k1.b, 7);
-    bnz_set_str(&secp256k1.G.x, "55066263022277343669578718895168534326250603453777594175500187360389116729240", 10); // generator x
-    bnz_set_str(&secp256k1.G.y, "32670510020758816978083085130507043184471273380659243275938904335757337482424", 10); // generator y
-    bnz_set_str(&secp256k1.n, "115792089237316195423570985008687907852837564279074904382605163141518161494337", 10); // order
-    bnz_set_i32(&secp256k1.h, 1);
+    memset(naf, 0, 257 * sizeof(int32_t));
 
-    return secp256k1;
+    while (bit < 256) {
+        if ((uint32_t)u256_bit_set(k, bit) == carry) { // a zero digit, counting a pending carry
+            bit++;
+            continue;
+        }
+        now = bit + w > 256 ? 256 - bit : w;
+        word = (int32_t)(u256_get_bits(k, bit, now) + carry);
+        carry = (word >> (w - 1)) & 1; // digits of 2^(w - 1) and above become negative and carry into the next window
+        word -= (int32_t)(carry << w);
+        naf[bit] = word;
+        len = bit + 1;
+        bit += now;
+    }
+    if (carry) {
+        naf[256] = 1;
+        len = 257;
+    }
+    return len;
 }
 
-void secp256k1_free(SECP256K1 secp256k1) // free secp256k1 curve
+void secp256k1_jac_odd_multiples(PTJ *t, PTJ *p, size_t n) // t[i] = (2i + 1) * p for i < n
 {
-    bnz_free(&secp256k1.p);
-    bnz_free(&secp256k1.a);
-    bnz_free(&secp256k1.b);
-    bnz_free(&secp256k1.G.x);
-    bnz_free(&secp256k1.G.y);
-    bnz_free(&secp256k1.n);
-    bnz_free(&secp256k1.h);
+    size_t i;
+    PTJ p2;
+
+    t[0] = *p;
+    secp256k1_jac_double(&p2, p);
+    for (i = 1; i < n; i++) secp256k1_jac_add(&t[i], &t[i - 1], &p2);
 }
 
-void secp256k1_point_doubling(SECP256K1 secp256k1, PT *p, PT *r) // r = 2p on secp256k1
+void secp256k1_jac_add_naf(PTJ *acc, PTJ *t, int32_t d) // acc = acc + d * p for a naf digit d and t the odd multiples of p
 {
-    bnz_t slope, tmp;
-
-    bnz_init(&tmp);
-    bnz_init(&slope);
-
-    if (!bnz_is_zero(&p->y)) {
-        bnz_multiply_i32(&tmp, &p->y, 2);
-        bnz_modular_multiplicative_inverse(&tmp, &tmp, &secp256k1.p);
-        bnz_multiply_bnz(&slope, &p->x, &p->x);
-        bnz_multiply_i32(&slope, &slope, 3);
-        bnz_add_bnz(&slope, &slope, &secp256k1.a);
-        bnz_multiply_bnz(&slope, &slope, &tmp);
-        bnz_mod_bnz(&slope, &slope, &secp256k1.p);
-        bnz_multiply_bnz(&r->x, &slope, &slope);
-        bnz_subtract_bnz(&r->x, &r->x, &p->x);
-        bnz_subtract_bnz(&r->x, &r->x, &p->x);
-        bnz_mod_bnz(&r->x, &r->x, &secp256k1.p);
-        bnz_subtract_bnz(&tmp, &p->x, &r->x);
-        bnz_multiply_bnz(&r->y, &slope, &tmp);
-        bnz_subtract_bnz(&r->y, &r->y, &p->y);
-        bnz_mod_bnz(&r->y, &r->y, &secp256k1.p);
-    } else {
-        bnz_set_i32(&r->x, 0);
-        bnz_set_i32(&r->y, 0);
+    PTJ neg;
+
+    if (d > 0) {
+        secp256k1_jac_add(acc, acc, &t[d >> 1]);
+    } else if (d < 0) {
+        neg = t[-d >> 1];
+        fe_negate(&neg.y, &neg.y);
+        secp256k1_jac_add(acc, acc, &neg);
     }
-
-    bnz_free(&tmp);
-    bnz_free(&slope);
 }
 
-void secp256k1_point_addition(SECP256K1 secp256k1, PT *p, PT *q, PT *r) // r = (p + q) mod secp256k1.p
+void secp256k1_jac_add_naf_affine(PTJ *acc, PT *t, int32_t d) // acc = acc + d * p for a naf digit d and t the affine odd multiples of p
 {
-    bnz_t tmp, slope;
+    PT neg;
+    fe_t y;
+
+    if (d > 0) {
+        secp256k1_jac_add_affine(acc, acc, &t[d >> 1]);
+    } else if (d < 0) {
+        neg.x = t[-d >> 1].x;
+        fe_set_u256(&y, &t[-d >> 1].y);
+        fe_negate(&y, &y);
+        fe_get_u256(&neg.y, &y);
+        secp256k1_jac_add_affine(acc, acc, &neg);
+    }
+}
 
-    bnz_init(&tmp);
-    bnz_init(&slope);
+void secp256k1_mul_shift_384(u256_t *r, u256_t *a, u256_t *b) // r = a * b / 2^384 rounded to nearest
+{
+    u512_t t;
 
-    bnz_set_i32(&slope, 0);
+    u256_mul(&t, a, b);
+    memset(r->limbs, 0, sizeof(r->limbs));
+    memcpy(r->limbs, t.limbs + 384 / BNZ_LIMB_BITS, (2 * U256_LIMBS - 384 / BNZ_LIMB_BITS) * sizeof(bnz_limb_t));
+    if ((t.limbs[383 / BNZ_LIMB_BITS] >> (383 % BNZ_LIMB_BITS)) & 1) add_1_limb_arr(r->limbs, r->limbs, U256_LIMBS, 1);
+}
 
-    bnz_mod_bnz(&p->x, &p->x, &secp256k1.p);
-    bnz_mod_bnz(&p->y, &p->y, &secp256k1.p);
-    bnz_mod_bnz(&q->x, &q->x, &secp256k1.p);
-    bnz_mod_bnz(&q->y, &q->y, &secp256k1.p);
+void secp256k1_scalar_split_lambda(const SECP256K1 *secp256k1, u256_t *k1, int32_t *neg1, u256_t *k2, int32_t *neg2, u256_t *k) // k = k1 + k2 * lambda mod n with k1 and k2 below 2^128 in magnitude, returned as magnitudes with their signs in neg1 and neg2
+{
+    u256_t kk, c1, c2;
+
+    u256_mod(&kk, k, (u256_t *)&secp256k1->n);
+
+    secp256k1_mul_shift_384(&c1, &kk, (u256_t *)&secp256k1->g1);
+    secp256k1_mul_shift_384(&c2, &kk, (u256_t *)&secp256k1->g2);
+    u256_barrett_mul(&c1, &c1, (u256_t *)&secp256k1->minus_b1, (u256_barrett_t *)&secp256k1->n_barrett);
+    u256_barrett_mul(&c2, &c2, (u256_t *)&secp256k1->minus_b2, (u256_barrett_t *)&secp256k1->n_barrett);
+    u256_mod_add(k2, &c1, &c2, (u256_t *)&secp256k1->n); // k2 = -(c1 b1 + c2 b2)
+    u256_barrett_mul(&c1, k2, (u256_t *)&secp256k1->lambda, (u256_barrett_t *)&secp256k1->n_barrett);
+    u256_mod_sub(k1, &kk, &c1, (u256_t *)&secp256k1->n); // k1 = k - k2 lambda
+
+    u256_sub(&c1, (u256_t *)&secp256k1->n, k1); // take n - k when it is the shorter of the two
+    *neg1 = u256_cmp(&c1, k1) < 0;
+    if (*neg1) *k1 = c1;
+    u256_sub(&c2, (u256_t *)&secp256k1->n, k2);
+    *neg2 = u256_cmp(&c2, k2) < 0;
+    if (*neg2) *k2 = c2;
+}
 
-    if (bnz_is_zero(&p->x) && bnz_is_zero(&p->y)) {
-        bnz_set_bnz(&r->x, &q->x);
-        bnz_set_bnz(&r->y, &q->y);
-        bnz_free(&tmp);
-        bnz_free(&slope);
-        return;
+void secp256k1_point_multiply(const SECP256K1 *secp256k1, PT *r, PT *p, u256_t *k) // r = k * p for any point p, by width w naf with a per call table of odd multiples of p, over the two 128 bit halves of k when SECP256K1_GLV is set, one inversion at the end
+{
+    int32_t naf[257];
+    size_t len, i;
+    PTJ t[1 << (SECP256K1_WNAF_WINDOW - 2)], pj, acc;
+#if SECP256K1_GLV
+    int32_t naf_lam[257], neg1, neg2;
+    size_t len_lam;
+    u256_t k1, k2;
+    PTJ t_lam[1 << (SECP256K1_WNAF_WINDOW - 2)];
+    fe_t beta;
+#endif
+
+    secp256k1_jac_set_pt(&pj, p);
+    acc.infinity = 1;
+
+#if SECP256K1_GLV
+    secp256k1_scalar_split_lambda(secp256k1, &k1, &neg1, &k2, &neg2, k);
+    len = secp256k1_wnaf(naf, &k1, SECP256K1_WNAF_WINDOW);
+    len_lam = secp256k1_wnaf(naf_lam, &k2, SECP256K1_WNAF_WINDOW);
+    if (len_lam > len) len = len_lam;
+
+    if (!pj.infinity && len) {
+        if (neg1) fe_negate(&pj.y, &pj.y);
+        secp256k1_jac_odd_multiples(t, &pj, (size_t)1 << (SECP256K1_WNAF_WINDOW - 2));
+        fe_set_u256(&beta, (u256_t *)&secp256k1->beta);
+        for (i = 0; i < ((size_t)1 << (SECP256K1_WNAF_WINDOW - 2)); i++) { // lambda * t[i] = (beta * x, y, z), negated when the halves differ in sign
+            t_lam[i] = t[i];
+            fe_mul(&t_lam[i].x, &t_lam[i].x, &beta);
+            if (neg1 != neg2) fe_negate(&t_lam[i].y, &t_lam[i].y);
+        }
+        for (i = len; i > 0; i--) { // the halves share every doubling
+            secp256k1_jac_double(&acc, &acc);
+            secp256k1_jac_add_naf(&acc, t, naf[i - 1]);
+            secp256k1_jac_add_naf(&acc, t_lam, naf_lam[i - 1]);
+        }
     }
-
-    if (bnz_is_zero(&q->x) && bnz_is_zero(&q->y)) {
-        bnz_set_bnz(&r->x, &p->x);
-        bnz_set_bnz(&r->y, &p->y);
-        bnz_free(&tmp);
-        bnz_free(&slope);
-        return;
+#else
+    len = secp256k1_wnaf(naf, k, SECP256K1_WNAF_WINDOW);
+
+    if (!pj.infinity && len) {
+        secp256k1_jac_odd_multiples(t, &pj, (size_t)1 << (SECP256K1_WNAF_WINDOW - 2));
+        for (i = len; i > 0; i--) {
+            secp256k1_jac_double(&acc, &acc);
+            secp256k1_jac_add_naf(&acc, t, naf[i - 1]);
+        }
     }
+#endif
 
-    if (!bnz_is_zero(&q->y)) {
-        bnz_subtract_bnz(&tmp, &secp256k1.p, &q->y);
-        bnz_mod_bnz(&tmp, &tmp, &secp256k1.p);
-    } else {
-        bnz_set_i32(&tmp, 0);
-    }
+    secp256k1_jac_get_pt(r, &acc, 0);
+}
 
-    if (bnz_cmp_bnz(&p->y, &tmp) == 0 && bnz_cmp_bnz(&p->x, &q->x) == 0) {
-        bnz_set_i32(&r->x, 0);
-        bnz_set_i32(&r->y, 0);
-        bnz_free(&tmp);
-        bnz_free(&slope);
-        return;
+void secp256k1_dual_multiply_jac(const SECP256K1 *secp256k1, PTJ *r, u256_t *a, PT *p, u256_t *b) // r = a * G + b * p in jacobian coordinates by strauss-shamir, one shared run of doublings over the naf digits of both scalars, G from the precomputed odd multiples and p from a per call table
+{
+    int32_t naf_g[257], naf_p[257];
+    size_t len, len_p, i;
+    PTJ t[1 << (SECP256K1_WNAF_WINDOW - 2)], pj;
+#if SECP256K1_GLV
+    int32_t naf_g_lam[257], naf_p_lam[257], neg1, neg2;
+    u256_t k1, k2;
+    PTJ t_lam[1 << (SECP256K1_WNAF_WINDOW - 2)];
+    fe_t beta;
+#endif
+
+    secp256k1_gen_table_init(secp256k1);
+    secp256k1_jac_set_pt(&pj, p);
+    r->infinity = 1;
+
+#if SECP256K1_GLV
+    secp256k1_scalar_split_lambda(secp256k1, &k1, &neg1, &k2, &neg2, a);
+    len = secp256k1_wnaf(naf_g, &k1, SECP256K1_WNAF_G_WINDOW);
+    len_p = secp256k1_wnaf(naf_g_lam, &k2, SECP256K1_WNAF_G_WINDOW);
+    if (len_p > len) len = len_p;
+    for (i = 0; i < 257; i++) { // the G tables are fixed, so the signs of the halves go on the digits
+        if (neg1) naf_g[i] = -naf_g[i];
+        if (neg2) naf_g_lam[i] = -naf_g_lam[i];
     }
 
-    if (bnz_cmp_bnz(&p->x, &q->x) == 0 && bnz_cmp_bnz(&p->y, &q->y) == 0) {
-        secp256k1_point_doubling(secp256k1, p, r);
-    } else {
-        bnz_subtract_bnz(&tmp, &p->x, &q->x);
-        bnz_mod_bnz(&tmp, &tmp, &secp256k1.p);
-        bnz_modular_multiplicative_inverse(&tmp, &tmp, &secp256k1.p);
-        bnz_subtract_bnz(&slope, &p->y, &q->y);
-        bnz_multiply_bnz(&slope, &slope, &tmp);
-        bnz_mod_bnz(&slope, &slope, &secp256k1.p);
-        bnz_multiply_bnz(&r->x, &slope, &slope);
-        bnz_subtract_bnz(&r->x, &r->x, &p->x);
-        bnz_subtract_bnz(&r->x, &r->x, &q->x);
-        bnz_mod_bnz(&r->x, &r->x, &secp256k1.p);
-        bnz_subtract_bnz(&tmp, &p->x, &r->x);
-        bnz_multiply_bnz(&r->y, &slope, &tmp);
-        bnz_subtract_bnz(&r->y, &r->y, &p->y);
-        bnz_mod_bnz(&r->y, &r->y, &secp256k1.p);
+    secp256k1_scalar_split_lambda(secp256k1, &k1, &neg1, &k2, &neg2, b);
+    len_p = secp256k1_wnaf(naf_p, &k1, SECP256K1_WNAF_WINDOW);
+    i = secp256k1_wnaf(naf_p_lam, &k2, SECP256K1_WNAF_WINDOW);
+    if (i > len_p) len_p = i;
+    if (pj.infinity) len_p = 0;
+
+    if (len_p) {
+        if (neg1) fe_negate(&pj.y, &pj.y);
+        secp256k1_jac_odd_multiples(t, &pj, (size_t)1 << (SECP256K1_WNAF_WINDOW - 2));
+        fe_set_u256(&beta, (u256_t *)&secp256k1->beta);
+        for (i = 0; i < ((size_t)1 << (SECP256K1_WNAF_WINDOW - 2)); i++) {
+            t_lam[i] = t[i];
+            fe_mul(&t_lam[i].x, &t_lam[i].x, &beta);
+            if (neg1 != neg2) fe_negate(&t_lam[i].y, &t_lam[i].y);
+        }
     }
-
-    bnz_free(&tmp);
-    bnz_free(&slope);
+    if (len_p > len) len = len_p;
+
+    for (i = len; i > 0; i--) { // four 128 bit scalars share every doubling
+        secp256k1_jac_double(r, r);
+        secp256k1_jac_add_naf_affine(r, secp256k1->gen_odd[0], naf_g[i - 1]);
+        secp256k1_jac_add_naf_affine(r, secp256k1->gen_odd[1], naf_g_lam[i - 1]);
+        if (i <= len_p) {
+            secp256k1_jac_add_naf(r, t, naf_p[i - 1]);
+            secp256k1_jac_add_naf(r, t_lam, naf_p_lam[i - 1]);
+        }
+    }
+#else
+    len = secp256k1_wnaf(naf_g, a, SECP256K1_WNAF_G_WINDOW);
+    len_p = pj.infinity ? 0 : secp256k1_wnaf(naf_p, b, SECP256K1_WNAF_WINDOW);
+    if (len_p) secp256k1_jac_odd_multiples(t, &pj, (size_t)1 << (SECP256K1_WNAF_WINDOW - 2));
+    if (len_p > len) len = len_p;
+
+    for (i = len; i > 0; i--) {
+        secp256k1_jac_double(r, r);
+        secp256k1_jac_add_naf_affine(r, secp256k1->gen_odd[0], naf_g[i - 1]);
+        if (i <= len_p) secp256k1_jac_add_naf(r, t, naf_p[i - 1]);
+    }
+#endif
 }
 
-void secp256k1_scalar_multiplication(SECP256K1 secp256k1, PT *r, bnz_t *m) // r = (secp256k1.G * m) mod secp256k1.p
+int32_t secp256k1_self_check(const SECP256K1 *secp256k1) // return 1 if the batch, variable base and dual multiplications agree with the fixed base one on 8 fixed scalars, return 0 otherwise
 {
-    size_t i, bits = 8 * m->size;
-
-    PT q, tmp;
-
-    bnz_init(&q.x);
-    bnz_init(&q.y);
-    bnz_init(&tmp.x);
-    bnz_init(&tmp.y);
-
-    bnz_set_i32(&r->x, 0);
-    bnz_set_i32(&r->y, 0);
+    uint8_t digest[32];
+    u256_t k[8], one;
+    PT g[8], p, q, r, s;
+    PTJ rj;
+    size_t i;
 
-    if (bnz_is_zero(m)) {
-        bnz_free(&q.x);
-        bnz_free(&q.y);
-        bnz_free(&tmp.x);
-        bnz_free(&tmp.y);
-        return;
+    for (i = 0; i < 8; i++) { // 0, 1, n - 1 and hashes of the index
+        digest[0] = (uint8_t)i;
+        sha256(digest, 1, digest);
+        u256_set_bytes(&k[i], digest);
     }
+    u256_set_ui32(&k[0], 0);
+    u256_set_ui32(&k[1], 1);
+    u256_set_ui32(&one, 1);
+    u256_sub(&k[2], (u256_t *)&secp256k1->n, &one);
 
-    bnz_set_bnz(&q.x, &secp256k1.G.x);
-    bnz_set_bnz(&q.y, &secp256k1.G.y);
-
-    if (bnz_bit_set(m, 0) == 1) {
-        bnz_set_bnz(&r->x, &secp256k1.G.x);
-        bnz_set_bnz(&r->y, &secp256k1.G.y);
+    secp256k1_scalar_multiplication_batch(secp256k1, g, k, 8);
+    for (i = 0; i < 8; i++) {
+        secp256k1_scalar_multiplication(secp256k1, &q, &k[i]);
+        if (u256_cmp(&q.x, &g[i].x) || u256_cmp(&q.y, &g[i].y)) return 0;
     }
 
-    for (i = 1; i < bits; i++) {
-        bnz_set_i32(&tmp.x, 0);
-        bnz_set_i32(&tmp.y, 0);
-        secp256k1_point_doubling(secp256k1, &q, &tmp);
-        bnz_set_bnz(&q.x, &tmp.x);
-        bnz_set_bnz(&q.y, &tmp.y);
-        bnz_set_bnz(&tmp.x, &r->x);
-        bnz_set_bnz(&tmp.y, &r->y);
-        if (bnz_bit_set(m, i)) secp256k1_point_addition(secp256k1, &tmp, &q, r);
+    p = g[3];
+    for (i = 0; i < 8; i++) { // k[i] * G + k[i + 5] * p against the sum of the two products
+        secp256k1_dual_multiply_jac(secp256k1, &rj, &k[i], &p, &k[(i + 5) & 7]);
+        secp256k1_jac_get_pt(&r, &rj, 1);
+        secp256k1_point_multiply(secp256k1, &q, &p, &k[(i + 5) & 7]);
+        secp256k1_point_addition(&g[i], &q, &s);
+        if (u256_cmp(&r.x, &s.x) || u256_cmp(&r.y, &s.y)) return 0;
     }
 
-    bnz_free(&q.x);
-    bnz_free(&q.y);
-    bnz_free(&tmp.x);
-    bnz_free(&tmp.y);
+    return 1;
 }
 
 /* BITCOIN */
 
 uint8_t *get_salt(const char *);
+void u256_rnd(u256_t *);
 void bnz_256_bit_rnd(bnz_t *);
-void entropy_checksum(bnz_t *);
-void get_bip39_word_ids(bnz_t *, uint32_t *);
+uint8_t entropy_checksum(u256_t *);
+void get_bip39_word_ids(u256_t *, uint8_t, uint32_t *);
 uint8_t *get_mnemonic_phrase(uint32_t *);
-void get_seed_from_mnemonic_phrase(bnz_t *, const char *, const char *);
-void get_master_keys(bnz_t *, bnz_t *, bnz_t *);
-void get_public_key(PT *, bnz_t *, bnz_t *);
-void get_public_key_xy(PT *, bnz_t *);
-void get_random_master_keys(bnz_t *, bnz_t *, bnz_t *);
-void get_p2pkh_address(bnz_t *, bnz_t *);
+void get_seed_from_mnemonic_phrase(u512_t *, const char *, const char *);
+void get_master_keys(u256_t *, u256_t *, u512_t *);
+void get_public_key(PT *, uint8_t *, u256_t *);
+int32_t get_public_key_xy(PT *, uint8_t *);
+void get_random_master_keys(u256_t *, u256_t *, u256_t *);
+void get_p2pkh_address(uint8_t *, uint8_t *);
 
 uint8_t *get_salt(const char *passphrase) // generate salt string from passphrase
 {
@@ -2455,55 +5627,51 @@ uint8_t *get_salt(const char *passphrase) // generate salt string from passphras
     return salt;
 }
 
-void bnz_256_bit_rnd(bnz_t *rnd) // generate pseudo random 256 bit entropy - NOT SECURE
+void u256_rnd(u256_t *rnd) // generate pseudo random 256 bit entropy - NOT SECURE
 {
+    uint8_t bytes[32];
     size_t i;
-    bnz_resize(rnd, 32, 0);
     for (i = 0; i < 32; i++) {
-        rnd->digits[i] = rand() & 255;
+        bytes[i] = rand() & 255;
     }
+    u256_set_bytes(rnd, bytes);
 }
 
-void entropy_checksum(bnz_t *entropy) // append checksum byte to 256 bits of entropy
+void bnz_256_bit_rnd(bnz_t *rnd) // generate pseudo random 256 bit entropy as bnz_t - NOT SECURE
 {
-    uint8_t sha256_digest[32];
-    bnz_t tmp;
-    bnz_init(&tmp);
+    u256_t tmp;
+    u256_rnd(&tmp);
+    bnz_set_limbs(rnd, tmp.limbs, U256_LIMBS);
+}
 
-    bnz_set_bnz(&tmp, entropy);
-    bnz_resize(&tmp, 32, 1);
-    bnz_reverse_digits(&tmp);
-    sha256(tmp.digits, tmp.size, sha256_digest);
+uint8_t entropy_checksum(u256_t *entropy) // return the checksum byte of 256 bits of entropy
+{
+    uint8_t bytes[32], sha256_digest[32];
 
-    bnz_concatenate_ui8(&tmp, &tmp, sha256_digest[0], 0);
-    bnz_reverse_digits(&tmp);
-    
-    bnz_set_bnz(entropy, &tmp);
-    bnz_free(&tmp);
+    u256_get_bytes(entropy, bytes);
+    sha256(bytes, 32, sha256_digest);
+
+    return sha256_digest[0];
 }
 
-void get_bip39_word_ids(bnz_t *entropy_chk, uint32_t *wd_ids) // convert 33 bytes into 24 numbers of 11 bits
+void get_bip39_word_ids(u256_t *entropy, uint8_t checksum, uint32_t *wd_ids) // convert 32 bytes of entropy and checksum byte into 24 numbers of 11 bits
 {
+    uint8_t bytes[33];
     size_t i;
-    bnz_t tmp;
-    bnz_init(&tmp);
 
-    bnz_set_bnz(&tmp, entropy_chk);
-    bnz_resize(&tmp, 33, 1);
-    bnz_reverse_digits(&tmp);
+    u256_get_bytes(entropy, bytes);
+    bytes[32] = checksum; // checksum byte at lsb end
 
     for (i = 0; i < 3; i++) {
-        wd_ids[(i * 8) + 0] = ((((uint32_t)tmp.digits[(i * 11) + 0]) << 3) & 2040) + ((((uint32_t)tmp.digits[(i * 11) + 1]) >> 5) & 7);
-        wd_ids[(i * 8) + 1] = ((((uint32_t)tmp.digits[(i * 11) + 1]) << 6) & 1984) + ((((uint32_t)tmp.digits[(i * 11) + 2]) >> 2) & 63);
-        wd_ids[(i * 8) + 2] = ((((uint32_t)tmp.digits[(i * 11) + 2]) << 9) & 1536) + ((((uint32_t)tmp.digits[(i * 11) + 3]) << 1) & 510) + ((((uint32_t)tmp.digits[(i * 11) + 4]) >> 7) & 1);
-        wd_ids[(i * 8) + 3] = ((((uint32_t)tmp.digits[(i * 11) + 4]) << 4) & 2032) + ((((uint32_t)tmp.digits[(i * 11) + 5]) >> 4) & 15);
-        wd_ids[(i * 8) + 4] = ((((uint32_t)tmp.digits[(i * 11) + 5]) << 7) & 1920) + ((((uint32_t)tmp.digits[(i * 11) + 6]) >> 1) & 127);
-        wd_ids[(i * 8) + 5] = ((((uint32_t)tmp.digits[(i * 11) + 6]) << 10) & 1024) + ((((uint32_t)tmp.digits[(i * 11) + 7]) << 2) & 2044) + ((((uint32_t)tmp.digits[(i * 11) + 8]) >> 6) & 3);
-        wd_ids[(i * 8) + 6] = ((((uint32_t)tmp.digits[(i * 11) + 8]) << 5) & 2016) + ((((uint32_t)tmp.digits[(i * 11) + 9]) >> 3) & 31);
-        wd_ids[(i * 8) + 7] = ((((uint32_t)tmp.digits[(i * 11) + 9]) << 8) & 1792) + ((((uint32_t)tmp.digits[(i * 11) + 10])));
+        wd_ids[(i * 8) + 0] = ((((uint32_t)bytes[(i * 11) + 0]) << 3) & 2040) + ((((uint32_t)bytes[(i * 11) + 1]) >> 5) & 7);
+        wd_ids[(i * 8) + 1] = ((((uint32_t)bytes[(i * 11) + 1]) << 6) & 1984) + ((((uint32_t)bytes[(i * 11) + 2]) >> 2) & 63);
+        wd_ids[(i * 8) + 2] = ((((uint32_t)bytes[(i * 11) + 2]) << 9) & 1536) + ((((uint32_t)bytes[(i * 11) + 3]) << 1) & 510) + ((((uint32_t)bytes[(i * 11) + 4]) >> 7) & 1);
+        wd_ids[(i * 8) + 3] = ((((uint32_t)bytes[(i * 11) + 4]) << 4) & 2032) + ((((uint32_t)bytes[(i * 11) + 5]) >> 4) & 15);
+        wd_ids[(i * 8) + 4] = ((((uint32_t)bytes[(i * 11) + 5]) << 7) & 1920) + ((((uint32_t)bytes[(i * 11) + 6]) >> 1) & 127);
+        wd_ids[(i * 8) + 5] = ((((uint32_t)bytes[(i * 11) + 6]) << 10) & 1024) + ((((uint32_t)bytes[(i * 11) + 7]) << 2) & 2044) + ((((uint32_t)bytes[(i * 11) + 8]) >> 6) & 3);
+        wd_ids[(i * 8) + 6] = ((((uint32_t)bytes[(i * 11) + 8]) << 5) & 2016) + ((((uint32_t)bytes[(i * 11) + 9]) >> 3) & 31);
+        wd_ids[(i * 8) + 7] = ((((uint32_t)bytes[(i * 11) + 9]) << 8) & 1792) + ((((uint32_t)bytes[(i * 11) + 10])));
     }
-
-    bnz_free(&tmp);
 }
 
 uint8_t *get_mnemonic_phrase(uint32_t *wd_ids) // generate mnemonic string of 24 words
@@ -2521,141 +5689,106 @@ uint8_t *get_mnemonic_phrase(uint32_t *wd_ids) // generate mnemonic string of 24
     return(mnemonic_str);
 }
 
-void get_seed_from_mnemonic_phrase(bnz_t *seed, const char *mnemonic, const char *passphrase) // generate 64 byte seed from mnemonic string and optional passphrase
+void get_seed_from_mnemonic_phrase(u512_t *seed, const char *mnemonic, const char *passphrase) // generate 64 byte seed from mnemonic string and optional passphrase
 {
-    uint8_t tmp[64], *salt = NULL;
+    uint8_t tmp[64], bytes[64], *salt = NULL;
     size_t i, j;
-    bnz_resize(seed, 64, 0);
     if (!(salt = get_salt(passphrase))) return;
     hmac_sha512(mnemonic, strlen(mnemonic), salt, strlen(passphrase) + 12 /* strlen("mnemonic") + 4 bytes of uint32_t */, tmp, 64);
-    memcpy(seed->digits, tmp, 64);
+    memcpy(bytes, tmp, 64);
     for (i = 1; i < 2048; i++) {
         hmac_sha512(mnemonic, strlen(mnemonic), tmp, 64, tmp, 64);
         for (j = 0; j < 64; j++) {
-            seed->digits[j] = tmp[j] ^ seed->digits[j];
+            bytes[j] = tmp[j] ^ bytes[j];
         }
     }
-    bnz_reverse_digits(seed);
+    u512_set_bytes(seed, bytes);
     free(salt);
 }
 
-void get_master_keys(bnz_t *master_private_key, bnz_t *master_chain_code, bnz_t *seed) // generate 32 byte master private key and 32 byte master chain_code
+void get_master_keys(u256_t *master_private_key, u256_t *master_chain_code, u512_t *seed) // generate 32 byte master private key and 32 byte master chain_code
 {
-    uint8_t mac[64];
+    uint8_t bytes[64], mac[64];
 
-    bnz_t tmp;
-    bnz_init(&tmp);
-
-    bnz_set_bnz(&tmp, seed);
-
-    bnz_resize(&tmp, 64, 1);
-    bnz_reverse_digits(&tmp);
-    hmac_sha512("Bitcoin seed", 12, tmp.digits, tmp.size, mac, 64);
+    u512_get_bytes(seed, bytes);
+    hmac_sha512("Bitcoin seed", 12, bytes, 64, mac, 64);
 
-    bnz_resize(master_private_key, 32, 0);
-    memcpy(master_private_key->digits, mac, 32);
-    bnz_reverse_digits(master_private_key);
-
-    bnz_resize(master_chain_code, 32, 0);
-    memcpy(master_chain_code->digits, mac + 32, 32);
-    bnz_reverse_digits(master_chain_code);
-
-    bnz_free(&tmp);
+    u256_set_bytes(master_private_key, mac);
+    u256_set_bytes(master_chain_code, mac + 32);
 }
 
-void get_public_key(PT *public_key, bnz_t *public_key_compressed, bnz_t *private_key) // generate public key from private key
+void get_public_key(PT *public_key, uint8_t *public_key_compressed, u256_t *private_key) // generate public key and 33 byte compressed public key from private key
 {
-    SECP256K1 secp256k1 = secp256k1_init();
+    const SECP256K1 *secp256k1 = secp256k1_init();
 
     secp256k1_scalar_multiplication(secp256k1, public_key, private_key);
 
-    if (bnz_bit_set(&public_key->y, 0) == 0) { // even y
-        bnz_concatenate_ui8(public_key_compressed, &public_key->x, 2, 0); // prepend 2
-    } else { // odd
-        bnz_concatenate_ui8(public_key_compressed, &public_key->x, 3, 0); // prepend 3
-    }
-    
-    secp256k1_free(secp256k1);
+    public_key_compressed[0] = u256_bit_set(&public_key->y, 0) ? 3 : 2; // prepend 2 for even y, 3 for odd y
+    u256_get_bytes(&public_key->x, public_key_compressed + 1);
 }
 
-void get_public_key_xy(PT *public_key, bnz_t *public_key_compressed) // regenerate public key point from compressed public key
+int32_t get_public_key_xy(PT *public_key, uint8_t *public_key_compressed) // regenerate public key point from 33 byte compressed public key, return 0 and the point at infinity if it is not on the curve
 {
-    uint8_t typ = public_key_compressed->digits[public_key_compressed->size - 1]; // typ = 2 for even y, typ = 3 for odd y
-    bnz_t exp, y_sq;
-    SECP256K1 secp256k1;
-
-    bnz_init(&exp);
-    bnz_init(&y_sq);
-
-    secp256k1 = secp256k1_init();
-
-    bnz_set_str(&exp, "28948022309329048855892746252171976963317496166410141009864396001977208667916", 10); // (secp256k1.p + 1) / 4
-
-    bnz_set_bnz(&public_key->x, public_key_compressed); // public_key.x = compressed public key
-    bnz_resize(&public_key->x, public_key->x.size - 1, 1); // public_key.x = decompressed public key
-
-    bnz_set_bnz(&y_sq, &public_key->x); //y_sq = public_key.x
-    bnz_multiply_bnz(&y_sq, &y_sq, &public_key->x); //y_sq = public_key.x^2
-    bnz_multiply_bnz(&y_sq, &y_sq, &public_key->x); //y_sq = public_key.x^3
-    bnz_add_i32(&y_sq, &y_sq, 7); //y_sq = public_key.x^3 + 7
-    bnz_mod_bnz(&y_sq, &y_sq, &secp256k1.p); //y_sq mod p = (public_key.x^3 + 7) mod secp256k1.p
+    uint8_t typ = public_key_compressed[0]; // typ = 2 for even y, typ = 3 for odd y
+    u256_t px;
+    fe_t x, y, b;
+
+    u256_set_ui32(&public_key->x, 0);
+    u256_set_ui32(&public_key->y, 0);
+    if (typ != 2 && typ != 3) return 0;
+
+    u256_set_bytes(&px, public_key_compressed + 1); // public_key.x = compressed public key without typ byte
+    fe_set_u256(&x, &px);
+    fe_get_u256(&public_key->x, &x);
+    if (u256_cmp(&public_key->x, &px) != 0) { // x >= secp256k1.p
+        u256_set_ui32(&public_key->x, 0);
+        return 0;
+    }
 
-    bnz_mod_pow(&public_key->y, &y_sq, &exp, &secp256k1.p); // y = (y_sq^(secp256k1.p + 1) / 4) mod secp256k1.p
+    fe_set_ui32(&b, 7); // secp256k1.b
+    fe_sqr(&y, &x); //y_sq = public_key.x^2
+    fe_mul(&y, &y, &x); //y_sq = public_key.x^3
+    fe_add(&y, &y, &b); //y_sq = (public_key.x^3 + 7) mod secp256k1.p
 
-    if ((typ == 2 && bnz_bit_set(&public_key->y, 0) == 1) || (typ == 3 && bnz_bit_set(&public_key->y, 0) == 0)) { // mismatched typ and y
-        bnz_subtract_bnz(&public_key->y, &secp256k1.p, &public_key->y); // y = secp256k1 - y, negation of y mod p
+    if (!fe_sqrt(&y, &y)) { // y = (y_sq^(secp256k1.p + 1) / 4) mod secp256k1.p, no point with this x if it does not square back
+        u256_set_ui32(&public_key->x, 0);
+        return 0;
     }
+    fe_get_u256(&public_key->y, &y);
 
-    bnz_free(&exp);
-    bnz_free(&y_sq);
+    if ((typ == 2 && u256_bit_set(&public_key->y, 0) == 1) || (typ == 3 && u256_bit_set(&public_key->y, 0) == 0)) { // mismatched typ and y
+        fe_negate(&y, &y); // y = secp256k1 - y, negation of y mod p
+        fe_get_u256(&public_key->y, &y);
+    }
 
-    secp256k1_free(secp256k1);
+    return 1;
 }
 
-void get_random_master_keys(bnz_t *entropy, bnz_t *master_private_key, bnz_t *master_chain_code) // NOT SECURE use random 256 bit entropy to generate master private key and master chain code
+void get_random_master_keys(u256_t *entropy, u256_t *master_private_key, u256_t *master_chain_code) // NOT SECURE use random 256 bit entropy to generate master private key and master chain code
 {
     char *mnemonic = NULL;
     uint32_t wd_ids[24];
-    bnz_t tmp, seed;
-
-    bnz_init(&tmp);
-    bnz_init(&seed);
+    u512_t seed;
 
-    bnz_256_bit_rnd(entropy);
-    bnz_set_bnz(&tmp, entropy);
+    u256_rnd(entropy);
 
-    entropy_checksum(&tmp);
-    get_bip39_word_ids(&tmp, wd_ids);
+    get_bip39_word_ids(entropy, entropy_checksum(entropy), wd_ids);
     mnemonic = get_mnemonic_phrase(wd_ids);
     get_seed_from_mnemonic_phrase(&seed, mnemonic, "");
     get_master_keys(master_private_key, master_chain_code, &seed);
 
     free(mnemonic);
-    bnz_free(&tmp);
-    bnz_free(&seed);
 }
 
-void get_p2pkh_address(bnz_t *p2pkh, bnz_t *public_key_compressed) // get p2pkh address from compressed public key
+void get_p2pkh_address(uint8_t *address, uint8_t *public_key_compressed) // get 25 byte p2pkh address from 33 byte compressed public key
 {
-    uint8_t h1[32], h2[20], h3[32], h4[32];
-    bnz_t tmp;
-    bnz_init(&tmp);
-    bnz_set_bnz(&tmp, public_key_compressed); // copy public_key_compressed to tmp, digits in default bnz_t little endian order
-    bnz_reverse_digits(&tmp); // change digit order of tmp to big endian
-    sha256(tmp.digits, tmp.size, h1); // h1 = sha256(public_key_compressed), big endian order
+    uint8_t h1[32], h2[20], h3[32];
+    sha256(public_key_compressed, 33, h1); // h1 = sha256(public_key_compressed), big endian order
     ripemd160(h1, 32, h2); // h2 = ripemd160(sha256(public_key_compressed)), big endian order
-    bnz_resize(p2pkh, 20, 0); // prepare p2pkh.digits to receive the 20 bytes of h2
-    memcpy(p2pkh->digits, h2, 20); // copy h2 into p2pkh.digits, big endian order
-    bnz_concatenate_ui8(p2pkh, p2pkh, 0, 1); // concatenate 0 byte to msb end of p2pkh.digits
-    sha256(p2pkh->digits, 21, h3); // h3 = sha256(p2pkh.digits), big endian order
-    sha256(h3, 32, h4); // h4 = sha256(sha256(p2pkh.digits)), big endian order
-    bnz_concatenate_ui8(p2pkh, p2pkh, h4[0], 0); // add first
-    bnz_concatenate_ui8(p2pkh, p2pkh, h4[1], 0); // four bytes
-    bnz_concatenate_ui8(p2pkh, p2pkh, h4[2], 0); // of h4 to lsb
-    bnz_concatenate_ui8(p2pkh, p2pkh, h4[3], 0); // end of p2pkh
-    bnz_reverse_digits(p2pkh); // change digit order of p2pkh.digits to little endian, default for bnz_t
-    bnz_trim(p2pkh); // remove zero value bytes from msb end of p2pkh
-    bnz_free(&tmp); // free tmp
+    address[0] = 0; // version byte 0 at msb end of address
+    memcpy(address + 1, h2, 20); // copy h2 into address, big endian order
+    sha256d(address, 21, h3); // h3 = sha256(sha256(address[0..20])), big endian order
+    memcpy(address + 21, h3, 4); // add first four bytes of h3 to lsb end of address
 }
 
 /* MENU */
@@ -2701,19 +5834,14 @@ void menu_1_master_keys(const char *version) // input 256 bits of entropy and ge
 {
     int i;
     uint32_t wd_ids[24];
+    uint8_t checksum, master_public_key_compressed[33], address[25];
     char entropy_str[512], base = 16, passphrase_str[512], *mnemonic = NULL;
-    bnz_t entropy, master_private_key, master_chain_code, master_public_key, master_public_key_compressed, seed, p2pkh;
+    bnz_t tmp;
+    u256_t entropy, master_private_key, master_chain_code;
+    u512_t seed;
     PT public_key;
 
-    bnz_init(&entropy);
-    bnz_init(&master_private_key);
-    bnz_init(&master_chain_code);
-    bnz_init(&master_public_key);
-    bnz_init(&master_public_key_compressed);
-    bnz_init(&seed);
-    bnz_init(&p2pkh);
-    bnz_init(&public_key.x);
-    bnz_init(&public_key.y);
+    bnz_init(&tmp);
 
     system("cls");
     printf("%s\n\n", version);
@@ -2730,14 +5858,15 @@ void menu_1_master_keys(const char *version) // input 256 bits of entropy and ge
         printf("Base (2 - 64): ");
         base = get_num_input(2, 0, 64);
         if (base < 2) base = 16;
-        bnz_set_str(&entropy, entropy_str, base);
+        bnz_set_str(&tmp, entropy_str, base);
+        u256_set_bnz(&entropy, &tmp);
     } else {
-        bnz_256_bit_rnd(&entropy);
+        u256_rnd(&entropy);
     }
 
     system("cls");
     printf("%s\n\n", version);
-    bnz_print(&entropy, 16, "Entropy: ");
+    u256_print(&entropy, 16, "Entropy: ");
     if (base == 16) {
         printf("Base: 16\n");
     } else {
@@ -2749,7 +5878,7 @@ void menu_1_master_keys(const char *version) // input 256 bits of entropy and ge
 
     system("cls");
     printf("%s\n\n", version);
-    bnz_print(&entropy, 16, "ENTROPY: ");
+    u256_print(&entropy, 16, "ENTROPY: ");
     printf("BASE: 16\n");
 
     if (isalnum(passphrase_str[0])) {
@@ -2758,11 +5887,11 @@ void menu_1_master_keys(const char *version) // input 256 bits of entropy and ge
         printf("\n");
     }
 
-    entropy_checksum(&entropy);
+    checksum = entropy_checksum(&entropy);
 
-    get_bip39_word_ids(&entropy, wd_ids);
+    get_bip39_word_ids(&entropy, checksum, wd_ids);
 
-    printf("CHECKSUM: 0x%02x\n\n", entropy.digits[0]);
+    printf("CHECKSUM: 0x%02x\n\n", checksum);
 
     printf("BIP39 IDs: %d", wd_ids[0]);
     for (i = 1; i < 24; i++) {
@@ -2774,27 +5903,32 @@ void menu_1_master_keys(const char *version) // input 256 bits of entropy and ge
     printf("MNEMONIC PHRASE: %s\n\n", mnemonic);
 
     get_seed_from_mnemonic_phrase(&seed, mnemonic, passphrase_str);
-    bnz_print(&seed, 16, "SEED: ");
+    u512_print(&seed, 16, "SEED: ");
     printf("\n");
 
     get_master_keys(&master_private_key, &master_chain_code, &seed);
 
-    get_public_key(&public_key, &master_public_key_compressed, &master_private_key);
+    get_public_key(&public_key, master_public_key_compressed, &master_private_key);
 
-    bnz_print(&master_private_key, 16, "MASTER PRIVATE KEY: ");
-    bnz_print(&master_chain_code, 16, "MASTER CHAIN CODE: ");
-    bnz_print(&master_public_key_compressed, 16, "MASTER PUBLIC KEY COMPRESSED: ");
-    bnz_print(&public_key.x, 16, " x: ");
-    bnz_print(&public_key.y, 16, " y: ");
+    u256_print(&master_private_key, 16, "MASTER PRIVATE KEY: ");
+    u256_print(&master_chain_code, 16, "MASTER CHAIN CODE: ");
+    bnz_set_bytes(&tmp, master_public_key_compressed, 33);
+    bnz_print(&tmp, 16, "MASTER PUBLIC KEY COMPRESSED: ");
+    u256_print(&public_key.x, 16, " x: ");
+    u256_print(&public_key.y, 16, " y: ");
     printf("\n");
 
-    get_p2pkh_address(&p2pkh, &master_public_key_compressed);
+    get_p2pkh_address(address, master_public_key_compressed);
 
-    bnz_print(&p2pkh, 58, "P2PKH ADDRESS: 1");
+    bnz_set_bytes(&tmp, address, 25); // leading zero byte is dropped, printed as "1"
+    bnz_print(&tmp, 58, "P2PKH ADDRESS: 1");
     printf("\n");
 
     printf("press any key to continue...");
 
+    free(mnemonic);
+    bnz_free(&tmp);
+
     getchar();
 }
 
@@ -2825,28 +5959,17 @@ void menu_2_child_keys(const char *version)
 
 void menu_2_1_normal_child(const char *version)
 {
-    uint8_t parent_private_key_str[67], parent_chain_code_str[67], index_str[11], mac[65];
+    uint8_t parent_private_key_str[67], parent_chain_code_str[67], data[37], chain_code[32], mac[65], child_public_key_compressed[33];
     uint32_t index_num;
-    bnz_t tmp, index, entropy, parent_private_key, parent_chain_code, parent_public_key_compressed, child_private_key, child_chain_code, child_public_key_compressed;
+    bnz_t tmp;
+    u256_t entropy, parent_private_key, parent_chain_code, child_private_key, child_chain_code;
     PT parent_public_key_pt, child_public_key_pt;
-    SECP256K1 secp256k1;
+    const SECP256K1 *secp256k1;
 
     secp256k1 = secp256k1_init();
 
-    bnz_init(&parent_public_key_pt.x);
-    bnz_init(&parent_public_key_pt.y);
-    bnz_init(&child_public_key_pt.x);
-    bnz_init(&child_public_key_pt.y);
-
     bnz_init(&tmp);
-    bnz_init(&index);
-    bnz_init(&entropy);
-    bnz_init(&parent_private_key);
-    bnz_init(&parent_chain_code);
-    bnz_init(&parent_public_key_compressed);
-    bnz_init(&child_private_key);
-    bnz_init(&child_chain_code);
-    bnz_init(&child_public_key_compressed);
+    u256_set_ui32(&entropy, 0);
 
     system("cls");
     printf("%s\n\n", version);
@@ -2856,27 +5979,29 @@ void menu_2_1_normal_child(const char *version)
 
     if (isalnum(parent_private_key_str[0])) {
         printf("%s\n", parent_private_key_str);
-        bnz_set_str(&parent_private_key, parent_private_key_str, 16);
+        bnz_set_str(&tmp, parent_private_key_str, 16);
+        u256_set_bnz(&parent_private_key, &tmp);
         system("cls");
         printf("%s\n\n", version);
-        bnz_print(&parent_private_key, 16, "Parent private key: ");
+        u256_print(&parent_private_key, 16, "Parent private key: ");
         printf("Parent chain code: ");
         get_str_input(parent_chain_code_str, 66);
-        bnz_set_str(&parent_chain_code, parent_chain_code_str, 16);
+        bnz_set_str(&tmp, parent_chain_code_str, 16);
+        u256_set_bnz(&parent_chain_code, &tmp);
         system("cls");
         printf("%s\n\n", version);
-        bnz_print(&parent_private_key, 16, "Parent private key: ");
-        bnz_print(&parent_chain_code, 16, "Parent chain code: ");
+        u256_print(&parent_private_key, 16, "Parent private key: ");
+        u256_print(&parent_chain_code, 16, "Parent chain code: ");
     } else {
         get_random_master_keys(&entropy, &parent_private_key, &parent_chain_code);
         system("cls");
         printf("%s\n\n", version);
-        bnz_print(&entropy, 16, "Entropy: ");
-        bnz_print(&parent_private_key, 16, "Parent private key: ");
-        bnz_print(&parent_chain_code, 16, "Parent chain code: ");
+        u256_print(&entropy, 16, "Entropy: ");
+        u256_print(&parent_private_key, 16, "Parent private key: ");
+        u256_print(&parent_chain_code, 16, "Parent chain code: ");
     }
 
-    get_public_key(&parent_public_key_pt, &parent_public_key_compressed, &parent_private_key);
+    get_public_key(&parent_public_key_pt, data, &parent_private_key); // data[0 .. 32] = parent public key compressed
 
     printf("Index (0 to 2147483647): ");
     index_num = get_num_input(11, 0, 2147483647);
@@ -2884,12 +6009,13 @@ void menu_2_1_normal_child(const char *version)
     system("cls");
     printf("%s\n\n", version);
 
-    if (!bnz_is_zero(&entropy)) bnz_print(&entropy, 16, "ENTROPY: ");
-    bnz_print(&parent_private_key, 16, "PARENT PRIVATE KEY: ");
-    bnz_print(&parent_chain_code, 16, "PARENT CHAIN CODE: ");
-    bnz_print(&parent_public_key_compressed, 16, "PARENT PUBLIC KEY COMPRESSED: ");
-    bnz_print(&parent_public_key_pt.x, 16, " x: ");
-    bnz_print(&parent_public_key_pt.y, 16, " y: ");
+    if (!u256_is_zero(&entropy)) u256_print(&entropy, 16, "ENTROPY: ");
+    u256_print(&parent_private_key, 16, "PARENT PRIVATE KEY: ");
+    u256_print(&parent_chain_code, 16, "PARENT CHAIN CODE: ");
+    bnz_set_bytes(&tmp, data, 33);
+    bnz_print(&tmp, 16, "PARENT PUBLIC KEY COMPRESSED: ");
+    u256_print(&parent_public_key_pt.x, 16, " x: ");
+    u256_print(&parent_public_key_pt.y, 16, " y: ");
 
     printf("\n");
 
@@ -2897,85 +6023,53 @@ void menu_2_1_normal_child(const char *version)
 
     printf("\n");
 
-    bnz_resize(&tmp, 32, 1); // ensure that the parameters sent to the hmac-512 function are padded with leading zeros
-    bnz_resize(&parent_chain_code, 32, 1); // ditto
+    u256_get_bytes(&parent_chain_code, chain_code);
 
-    bnz_set_i32(&index, index_num);
-    bnz_resize(&index, 4, 1);
-    bnz_concatenate_bnz(&tmp, &parent_public_key_compressed, &index, 1);
+    data[33] = index_num >> 24; // concatenate with index as big endian uint32_t
+    data[34] = index_num >> 16;
+    data[35] = index_num >> 8;
+    data[36] = index_num;
 
-    bnz_reverse_digits(&tmp);
-    bnz_reverse_digits(&parent_chain_code);
+    hmac_sha512(chain_code, 32, data, 37, mac, 64);
 
-    hmac_sha512(parent_chain_code.digits, parent_chain_code.size, tmp.digits, tmp.size, mac, 64);
-    bnz_reverse_digits(&parent_chain_code);
+    u256_set_bytes(&child_private_key, mac);
 
-    bnz_resize(&child_private_key, 32, 0);
-    memcpy(child_private_key.digits, mac, 32);
-    bnz_reverse_digits(&child_private_key);
+    u256_mod(&child_private_key, &child_private_key, (u256_t *)&secp256k1->n);
+    u256_mod(&parent_private_key, &parent_private_key, (u256_t *)&secp256k1->n);
+    u256_mod_add(&child_private_key, &child_private_key, &parent_private_key, (u256_t *)&secp256k1->n); //child_private_key mod secp256ki.n
 
-    bnz_add_bnz(&child_private_key, &child_private_key, &parent_private_key); //child_private_key
-    bnz_mod_bnz(&child_private_key, &child_private_key, &secp256k1.n); //child_private_key mod secp256ki.n
+    u256_set_bytes(&child_chain_code, mac + 32);
 
-    bnz_resize(&child_chain_code, 32, 0);
-    memcpy(child_chain_code.digits, mac + 32, 32);
-    bnz_reverse_digits(&child_chain_code);
+    get_public_key(&child_public_key_pt, child_public_key_compressed, &child_private_key); // generate compressed public key from private key
 
-    get_public_key(&child_public_key_pt, &child_public_key_compressed, &child_private_key); // generate compressed public key from private key
-
-    bnz_print(&child_private_key, 16, "CHILD PRIVATE KEY: ");
-    bnz_print(&child_chain_code, 16, "CHILD CHAIN CODE: ");
-    bnz_print(&child_public_key_compressed, 16, "CHILD PUBLIC KEY COMPRESSED: ");
-    bnz_print(&child_public_key_pt.x, 16, " x: ");
-    bnz_print(&child_public_key_pt.y, 16, " y: ");
+    u256_print(&child_private_key, 16, "CHILD PRIVATE KEY: ");
+    u256_print(&child_chain_code, 16, "CHILD CHAIN CODE: ");
+    bnz_set_bytes(&tmp, child_public_key_compressed, 33);
+    bnz_print(&tmp, 16, "CHILD PUBLIC KEY COMPRESSED: ");
+    u256_print(&child_public_key_pt.x, 16, " x: ");
+    u256_print(&child_public_key_pt.y, 16, " y: ");
     printf("\n");
 
     printf("press any key to continue...");
 
-    bnz_free(&parent_public_key_pt.x);
-    bnz_free(&parent_public_key_pt.y);
-    bnz_free(&child_public_key_pt.x);
-    bnz_free(&child_public_key_pt.y);
-
     bnz_free(&tmp);
-    bnz_free(&index);
-    bnz_free(&entropy);
-    bnz_free(&parent_private_key);
-    bnz_free(&parent_chain_code);
-    bnz_free(&parent_public_key_compressed);
-    bnz_free(&child_private_key);
-    bnz_free(&child_chain_code);
-    bnz_free(&child_public_key_compressed);
-
-    secp256k1_free(secp256k1);
 
     getchar();
 }
 
 void menu_2_2_hardened_child(const char *version)
 {
-    uint8_t parent_private_key_str[67], parent_chain_code_str[67], index_str[11], mac[65];
+    uint8_t parent_private_key_str[67], parent_chain_code_str[67], data[37], chain_code[32], mac[65], parent_public_key_compressed[33], child_public_key_compressed[33];
     uint32_t index_num;
-    bnz_t tmp, index, entropy, parent_private_key, parent_chain_code, parent_public_key_compressed, child_private_key, child_chain_code, child_public_key_compressed;
+    bnz_t tmp;
+    u256_t entropy, parent_private_key, parent_chain_code, child_private_key, child_chain_code;
     PT parent_public_key_pt, child_public_key_pt;
-    SECP256K1 secp256k1;
+    const SECP256K1 *secp256k1;
 
     secp256k1 = secp256k1_init();
 
-    bnz_init(&parent_public_key_pt.x);
-    bnz_init(&parent_public_key_pt.y);
-    bnz_init(&child_public_key_pt.x);
-    bnz_init(&child_public_key_pt.y);
-
     bnz_init(&tmp);
-    bnz_init(&index);
-    bnz_init(&entropy);
-    bnz_init(&parent_private_key);
-    bnz_init(&parent_chain_code);
-    bnz_init(&parent_public_key_compressed);
-    bnz_init(&child_private_key);
-    bnz_init(&child_chain_code);
-    bnz_init(&child_public_key_compressed);
+    u256_set_ui32(&entropy, 0);
 
     system("cls");
     printf("%s\n\n", version);
@@ -2985,39 +6079,42 @@ void menu_2_2_hardened_child(const char *version)
 
     if (isalnum(parent_private_key_str[0])) {
         printf("%s\n", parent_private_key_str);
-        bnz_set_str(&parent_private_key, parent_private_key_str, 16);
+        bnz_set_str(&tmp, parent_private_key_str, 16);
+        u256_set_bnz(&parent_private_key, &tmp);
         system("cls");
         printf("%s\n\n", version);
-        bnz_print(&parent_private_key, 16, "Parent private key: ");
+        u256_print(&parent_private_key, 16, "Parent private key: ");
         printf("Parent chain code: ");
         get_str_input(parent_chain_code_str, 66);
-        bnz_set_str(&parent_chain_code, parent_chain_code_str, 16);
+        bnz_set_str(&tmp, parent_chain_code_str, 16);
+        u256_set_bnz(&parent_chain_code, &tmp);
         system("cls");
         printf("%s\n\n", version);
-        bnz_print(&parent_private_key, 16, "Parent private key: ");
-        bnz_print(&parent_chain_code, 16, "Parent chain code: ");
+        u256_print(&parent_private_key, 16, "Parent private key: ");
+        u256_print(&parent_chain_code, 16, "Parent chain code: ");
     } else {
         get_random_master_keys(&entropy, &parent_private_key, &parent_chain_code);
         system("cls");
         printf("%s\n\n", version);
-        bnz_print(&entropy, 16, "Entropy: ");
-        bnz_print(&parent_private_key, 16, "Parent private key: ");
-        bnz_print(&parent_chain_code, 16, "Parent chain code: ");
+        u256_print(&entropy, 16, "Entropy: ");
+        u256_print(&parent_private_key, 16, "Parent private key: ");
+        u256_print(&parent_chain_code, 16, "Parent chain code: ");
     }
 
-    get_public_key(&parent_public_key_pt, &parent_public_key_compressed, &parent_private_key);
+    get_public_key(&parent_public_key_pt, parent_public_key_compressed, &parent_private_key);
 
     printf("Index (2147483648 to 4294967295): ");
     index_num = get_num_input(10, 2147483648, 4294967295);
 
     system("cls");
     printf("%s\n\n", version);
-    if (!bnz_is_zero(&entropy)) bnz_print(&entropy, 16, "ENTROPY: ");
-    bnz_print(&parent_private_key, 16, "PARENT PRIVATE KEY: ");
-    bnz_print(&parent_chain_code, 16, "PARENT CHAIN CODE: ");
-    bnz_print(&parent_public_key_compressed, 16, "PARENT PUBLIC KEY COMPRESSED: ");
-    bnz_print(&parent_public_key_pt.x, 16, " x: ");
-    bnz_print(&parent_public_key_pt.y, 16, " y: ");
+    if (!u256_is_zero(&entropy)) u256_print(&entropy, 16, "ENTROPY: ");
+    u256_print(&parent_private_key, 16, "PARENT PRIVATE KEY: ");
+    u256_print(&parent_chain_code, 16, "PARENT CHAIN CODE: ");
+    bnz_set_bytes(&tmp, parent_public_key_compressed, 33);
+    bnz_print(&tmp, 16, "PARENT PUBLIC KEY COMPRESSED: ");
+    u256_print(&parent_public_key_pt.x, 16, " x: ");
+    u256_print(&parent_public_key_pt.y, 16, " y: ");
 
     printf("\n");
 
@@ -3025,83 +6122,57 @@ void menu_2_2_hardened_child(const char *version)
 
     printf("\n");
 
-    bnz_resize(&tmp, 32, 1); // ensure that the parameters sent to the hmac-512 function are padded with leading zeros
-    bnz_resize(&parent_private_key, 32, 1); // ditto
-    bnz_resize(&parent_chain_code, 32, 1); // ditto
-
-    bnz_set_ui32(&index, index_num);
-    bnz_resize(&index, 4, 1);
-    bnz_concatenate_bnz(&tmp, &parent_private_key, &index, 1); // concatenate with index as uint32_t
-    bnz_concatenate_ui8(&tmp, &tmp, 0, 0); // prepend 0x00
+    data[0] = 0; // prepend 0x00
+    u256_get_bytes(&parent_private_key, data + 1);
+    u256_get_bytes(&parent_chain_code, chain_code);
 
-    bnz_reverse_digits(&tmp);
-    bnz_reverse_digits(&parent_chain_code);
+    data[33] = index_num >> 24; // concatenate with index as big endian uint32_t
+    data[34] = index_num >> 16;
+    data[35] = index_num >> 8;
+    data[36] = index_num;
 
-    hmac_sha512(parent_chain_code.digits, parent_chain_code.size, tmp.digits, tmp.size, mac, 64);
-    bnz_reverse_digits(&parent_chain_code);
+    hmac_sha512(chain_code, 32, data, 37, mac, 64);
 
-    bnz_resize(&child_private_key, 32, 0);
-    memcpy(child_private_key.digits, mac, 32);
-    bnz_reverse_digits(&child_private_key);
+    u256_set_bytes(&child_private_key, mac);
 
-    bnz_add_bnz(&child_private_key, &child_private_key, &parent_private_key);
-    bnz_mod_bnz(&child_private_key, &child_private_key, &secp256k1.n); //child_private_key % secp256ki.n
+    u256_mod(&child_private_key, &child_private_key, (u256_t *)&secp256k1->n);
+    u256_mod(&parent_private_key, &parent_private_key, (u256_t *)&secp256k1->n);
+    u256_mod_add(&child_private_key, &child_private_key, &parent_private_key, (u256_t *)&secp256k1->n); //child_private_key % secp256ki.n
 
-    bnz_resize(&child_chain_code, 32, 0);
-    memcpy(child_chain_code.digits, mac + 32, 32);
-    bnz_reverse_digits(&child_chain_code);
+    u256_set_bytes(&child_chain_code, mac + 32);
 
-    get_public_key(&child_public_key_pt, &child_public_key_compressed, &child_private_key); // generate compressed public key from private key
+    get_public_key(&child_public_key_pt, child_public_key_compressed, &child_private_key); // generate compressed public key from private key
 
-    bnz_print(&child_private_key, 16, "CHILD PRIVATE KEY: ");
-    bnz_print(&child_chain_code, 16, "CHILD CHAIN CODE: ");
-    bnz_print(&child_public_key_compressed, 16, "CHILD PUBLIC KEY COMPRESSED: ");
-    bnz_print(&child_public_key_pt.x, 16, " x: ");
-    bnz_print(&child_public_key_pt.y, 16, " y: ");
+    u256_print(&child_private_key, 16, "CHILD PRIVATE KEY: ");
+    u256_print(&child_chain_code, 16, "CHILD CHAIN CODE: ");
+    bnz_set_bytes(&tmp, child_public_key_compressed, 33);
+    bnz_print(&tmp, 16, "CHILD PUBLIC KEY COMPRESSED: ");
+    u256_print(&child_public_key_pt.x, 16, " x: ");
+    u256_print(&child_public_key_pt.y, 16, " y: ");
 
     printf("\n");
 
     printf("press any key to continue...");
-    
-    bnz_free(&child_public_key_pt.x);
-    bnz_free(&child_public_key_pt.y);
 
     bnz_free(&tmp);
-    bnz_free(&index);
-    bnz_free(&entropy);
-    bnz_free(&parent_private_key);
-    bnz_free(&parent_chain_code);
-    bnz_free(&parent_public_key_compressed);
-    bnz_free(&child_private_key);
-    bnz_free(&child_chain_code);
-    bnz_free(&child_public_key_compressed);
-
-    secp256k1_free(secp256k1);
 
     getchar();
 }
 
 void menu_2_3_public_child(const char *version)
 {
-    uint8_t parent_public_key_compressed_str[69], parent_chain_code_str[67], index_str[11], mac[65];
+    uint8_t parent_public_key_compressed_str[69], parent_chain_code_str[67], data[37], chain_code[32], mac[65];
     uint32_t index_num;
-    bnz_t parent_public_key_compressed, parent_chain_code, child_public_key_compressed, child_chain_code, index, tmp;
-    PT tmp_key, parent_public_key, child_public_key;
+    bnz_t parent_public_key_compressed, child_public_key_compressed, tmp;
+    u256_t parent_chain_code, child_chain_code, il;
+    PT parent_public_key, child_public_key;
+    PTJ child_public_key_jac;
 
-    SECP256K1 secp256k1;
+    const SECP256K1 *secp256k1;
 
     bnz_init(&tmp);
-    bnz_init(&index);
     bnz_init(&parent_public_key_compressed);
-    bnz_init(&parent_chain_code);
     bnz_init(&child_public_key_compressed);
-    bnz_init(&child_chain_code);
-    bnz_init(&tmp_key.x);
-    bnz_init(&tmp_key.y);
-    bnz_init(&parent_public_key.x);
-    bnz_init(&parent_public_key.y);
-    bnz_init(&child_public_key.x);
-    bnz_init(&child_public_key.y);
 
     secp256k1 = secp256k1_init();
 
@@ -3119,11 +6190,12 @@ void menu_2_3_public_child(const char *version)
         bnz_print(&parent_public_key_compressed, 16, "Parent public key compressed: ");
         printf("Parent chain code: ");
         get_str_input(parent_chain_code_str, 66); // 32 bytes + optional "0x"
-        bnz_set_str(&parent_chain_code, parent_chain_code_str, 16);
+        bnz_set_str(&tmp, parent_chain_code_str, 16);
+        u256_set_bnz(&parent_chain_code, &tmp);
         system("cls");
         printf("%s\n\n", version);
         bnz_print(&parent_public_key_compressed, 16, "Parent public key compressed: ");
-        bnz_print(&parent_chain_code, 16, "Parent chain code: ");
+        u256_print(&parent_chain_code, 16, "Parent chain code: ");
     } else {
         return;
     }
@@ -3131,72 +6203,61 @@ void menu_2_3_public_child(const char *version)
     printf("Index (0 to 2147483647): ");
     index_num = get_num_input(10, 0, 2147483647);
 
-    get_public_key_xy(&parent_public_key, &parent_public_key_compressed);
+    bnz_get_bytes(&parent_public_key_compressed, data, 33); // ensure that the parameters sent to the hmac-512 function are padded with leading zeros
+    u256_get_bytes(&parent_chain_code, chain_code);
+
+    if (!get_public_key_xy(&parent_public_key, data)) {
+        printf("Invalid public key\n\n");
+        printf("press any key to continue...");
+        bnz_free(&parent_public_key_compressed);
+        bnz_free(&child_public_key_compressed);
+        bnz_free(&tmp);
+        getchar();
+        return;
+    }
 
     system("cls");
     printf("%s\n\n", version);
 
-    bnz_print(&parent_chain_code, 16, "PARENT CHAIN CODE: ");
+    u256_print(&parent_chain_code, 16, "PARENT CHAIN CODE: ");
     bnz_print(&parent_public_key_compressed, 16, "PARENT PUBLIC KEY COMPRESSED: ");
-    bnz_print(&parent_public_key.x, 16, " x: ");
-    bnz_print(&parent_public_key.y, 16, " y: ");
+    u256_print(&parent_public_key.x, 16, " x: ");
+    u256_print(&parent_public_key.y, 16, " y: ");
     printf("\n");
 
     printf("INDEX: %u\n\n", index_num);
 
-    bnz_resize(&tmp, 32, 1); // ensure that the parameters sent to the hmac-512 function are padded with leading zeros
-    bnz_resize(&parent_chain_code, 32, 1); // ditto
-
-    bnz_set_i32(&index, index_num);
-    bnz_resize(&index, 4, 1);
-    bnz_concatenate_bnz(&tmp, &parent_public_key_compressed, &index, 1);
+    data[33] = index_num >> 24; // concatenate with index as big endian uint32_t
+    data[34] = index_num >> 16;
+    data[35] = index_num >> 8;
+    data[36] = index_num;
 
-    bnz_reverse_digits(&tmp);
-    bnz_reverse_digits(&parent_chain_code);
+    hmac_sha512(chain_code, 32, data, 37, mac, 64);
 
-    hmac_sha512(parent_chain_code.digits, parent_chain_code.size, tmp.digits, tmp.size, mac, 64);
-    bnz_reverse_digits(&parent_chain_code);
+    u256_set_bytes(&il, mac);
 
-    bnz_resize(&tmp, 32, 0);
-    memcpy(tmp.digits, mac, 32);
-    bnz_reverse_digits(&tmp);
+    secp256k1_scalar_multiplication_jac(secp256k1, &child_public_key_jac, &il); // child public key = il * G + parent public key, with one inversion
+    secp256k1_jac_add_affine(&child_public_key_jac, &child_public_key_jac, &parent_public_key);
+    secp256k1_jac_get_pt(&child_public_key, &child_public_key_jac, 0);
 
-    secp256k1_scalar_multiplication(secp256k1, &tmp_key, &tmp);
-    secp256k1_point_addition(secp256k1, &parent_public_key, &tmp_key, &child_public_key);
+    data[0] = u256_bit_set(&child_public_key.y, 0) ? 3 : 2; // prepend 2 for even y, 3 for odd y
+    u256_get_bytes(&child_public_key.x, data + 1);
+    bnz_set_bytes(&child_public_key_compressed, data, 33);
 
-    if (bnz_bit_set(&child_public_key.y, 0) == 0) { // even
-        bnz_concatenate_ui8(&child_public_key_compressed, &child_public_key.x, 2, 0); // prepend 2
-    } else { // odd
-        bnz_concatenate_ui8(&child_public_key_compressed, &child_public_key.x, 3, 0); // prepend 3
-    }
-
-    bnz_resize(&child_chain_code, 32, 0);
-    memcpy(child_chain_code.digits, mac + 32, 32);
-    bnz_reverse_digits(&child_chain_code);
+    u256_set_bytes(&child_chain_code, mac + 32);
 
-    bnz_print(&child_chain_code, 16, "CHILD CHAIN CODE: ");
+    u256_print(&child_chain_code, 16, "CHILD CHAIN CODE: ");
     bnz_print(&child_public_key_compressed, 16, "CHILD PUBLIC KEY COMPRESSED: ");
-    bnz_print(&child_public_key.x, 16, " x: ");
-    bnz_print(&child_public_key.y, 16, " y: ");
+    u256_print(&child_public_key.x, 16, " x: ");
+    u256_print(&child_public_key.y, 16, " y: ");
 
     printf("\n");
 
     printf("press any key to continue...");
 
     bnz_free(&parent_public_key_compressed);
-    bnz_free(&parent_chain_code);
     bnz_free(&child_public_key_compressed);
-    bnz_free(&child_chain_code);
-    bnz_free(&index);
     bnz_free(&tmp);
-    bnz_free(&tmp_key.x);
-    bnz_free(&tmp_key.y);
-    bnz_free(&parent_public_key.x);
-    bnz_free(&parent_public_key.y);
-    bnz_free(&child_public_key.x);
-    bnz_free(&child_public_key.y);
-
-    secp256k1_free(secp256k1);
 
     getchar();
 }
@@ -3372,7 +6433,7 @@ void menu_4_functions(const char *version)
 
 void menu_4_1_p2pkh(const char *version)
 {
-    uint8_t public_key_compressed_str[69]; // optional "0x" + 33 bytes + null terminator
+    uint8_t public_key_compressed_str[69], bytes[33], address[25]; // optional "0x" + 33 bytes + null terminator
     bnz_t public_key_compressed, p2pkh;
 
     bnz_init(&public_key_compressed);
@@ -3391,12 +6452,18 @@ void menu_4_1_p2pkh(const char *version)
     bnz_print(&public_key_compressed, 16, "PUBLIC KEY (COMPRESSED): ");
     printf("\n");
 
-    get_p2pkh_address(&p2pkh, &public_key_compressed);
+    bnz_get_bytes(&public_key_compressed, bytes, 33); // public_key_compressed as 33 bytes, big endian order
+    get_p2pkh_address(address, bytes);
+    bnz_set_bytes(&p2pkh, address, 25); // leading zero byte is dropped, printed as "1"
 
     bnz_print(&p2pkh, 58, "P2PKH: 1");
     printf("\n");
 
     printf("press any key to continue...");
+
+    bnz_free(&public_key_compressed);
+    bnz_free(&p2pkh);
+
     getchar();
 }
 
@@ -3404,117 +6471,113 @@ void menu_4_2_secp256k1_point_addition(const char *version)
 {
     uint8_t a_x_str[67], a_y_str[67], b_x_str[67], b_y_str[67];
     PT a, b, c;
-    bnz_t private_key;
-
-    SECP256K1 secp256k1;
-
-    secp256k1 = secp256k1_init();
+    bnz_t tmp;
 
-    bnz_init(&a.x);
-    bnz_init(&a.y);
-    bnz_init(&b.x);
-    bnz_init(&b.y);
-    bnz_init(&c.x);
-    bnz_init(&c.y);
+    bnz_init(&tmp);
 
     printf("Point 1 x: ");
     get_str_input(a_x_str, 66);
-    bnz_set_str(&a.x, a_x_str, 16);
+    bnz_set_str(&tmp, a_x_str, 16);
+    u256_set_bnz(&a.x, &tmp);
 
     printf("Point 1 y: ");
     get_str_input(a_y_str, 66);
-    bnz_set_str(&a.y, a_y_str, 16);
+    bnz_set_str(&tmp, a_y_str, 16);
+    u256_set_bnz(&a.y, &tmp);
 
     printf("Point 2 x: ");
     get_str_input(b_x_str, 66);
-    bnz_set_str(&b.x, b_x_str, 16);
+    bnz_set_str(&tmp, b_x_str, 16);
+    u256_set_bnz(&b.x, &tmp);
 
     printf("Point 2 y: ");
     get_str_input(b_y_str, 66);
-    bnz_set_str(&b.y, b_y_str, 16);
+    bnz_set_str(&tmp, b_y_str, 16);
+    u256_set_bnz(&b.y, &tmp);
 
-    secp256k1_point_addition(secp256k1, &a, &b, &c);
+    secp256k1_point_addition(&a, &b, &c);
 
     system("cls");
     printf("%s\n\n", version);
 
     printf("POINT 1:\n");
-    bnz_print(&a.x, 16, "x: ");
-    bnz_print(&a.y, 16, "y: ");
+    u256_print(&a.x, 16, "x: ");
+    u256_print(&a.y, 16, "y: ");
     printf("\n");
 
     printf("POINT 2:\n");
-    bnz_print(&b.x, 16, "x: ");
-    bnz_print(&b.y, 16, "y: ");
+    u256_print(&b.x, 16, "x: ");
+    u256_print(&b.y, 16, "y: ");
     printf("\n");
 
     printf("POINT 1 + POINT 2:\n");
-    bnz_print(&c.x, 16, "x: ");
-    bnz_print(&c.y, 16, "y: ");
+    u256_print(&c.x, 16, "x: ");
+    u256_print(&c.y, 16, "y: ");
     printf("\n");
 
     printf("press any key to continue...");
 
+    bnz_free(&tmp);
+
     getchar();
 }
 
 void menu_4_3_secp256k1_point_doubling(const char *version)
 {
-    uint8_t a_x_str[67], a_y_str[67], b_x_str[67], b_y_str[67];
+    uint8_t a_x_str[67], a_y_str[67];
     PT a, b;
-    bnz_t private_key;
-
-    SECP256K1 secp256k1;
-
-    secp256k1 = secp256k1_init();
+    bnz_t tmp;
 
-    bnz_init(&a.x);
-    bnz_init(&a.y);
-    bnz_init(&b.x);
-    bnz_init(&b.y);
+    bnz_init(&tmp);
 
     printf("Point x: ");
     get_str_input(a_x_str, 66);
-    bnz_set_str(&a.x, a_x_str, 16);
+    bnz_set_str(&tmp, a_x_str, 16);
+    u256_set_bnz(&a.x, &tmp);
 
     printf("Point y: ");
     get_str_input(a_y_str, 66);
-    bnz_set_str(&a.y, a_y_str, 16);
+    bnz_set_str(&tmp, a_y_str, 16);
+    u256_set_bnz(&a.y, &tmp);
 
-    secp256k1_point_doubling(secp256k1, &a, &b);
+    secp256k1_point_doubling(&a, &b);
 
     system("cls");
     printf("%s\n\n", version);
 
     printf("POINT:\n");
-    bnz_print(&a.x, 16, "x: ");
-    bnz_print(&a.y, 16, "y: ");
+    u256_print(&a.x, 16, "x: ");
+    u256_print(&a.y, 16, "y: ");
     printf("\n");
 
     printf("DOUBLED POINT:\n");
-    bnz_print(&b.x, 16, "x: ");
-    bnz_print(&b.y, 16, "y: ");
+    u256_print(&b.x, 16, "x: ");
+    u256_print(&b.y, 16, "y: ");
     printf("\n");
 
     printf("press any key to continue...");
 
+    bnz_free(&tmp);
+
     getchar();
 }
 
 void menu_4_4_secp256k1_scalar_multiplication(const char *version)
 {
     uint8_t multiplier_str[67];
-    bnz_t multiplier;
+    bnz_t multiplier, n;
+    u256_t m;
     PT p;
 
     bnz_init(&multiplier);
-    bnz_init(&p.x);
-    bnz_init(&p.y);
+    bnz_init(&n);
 
-    SECP256K1 secp256k1;
+    const SECP256K1 *secp256k1;
 
     secp256k1 = secp256k1_init();
 
+    bnz_set_limbs(&n, (bnz_limb_t *)secp256k1->n.limbs, U256_LIMBS);
+
     system("cls");
     printf("%s\n\n", version);
 
@@ -3525,8 +6588,8 @@ void menu_4_4_secp256k1_scalar_multiplication(const char *version)
     system("cls");
     printf("%s\n\n", version);
 
-    if (bnz_cmp_bnz(&multiplier, &secp256k1.n) != -1) {
-        bnz_mod_bnz(&multiplier, &multiplier, &secp256k1.n);
+    if (bnz_cmp_bnz(&multiplier, &n) != -1) {
+        bnz_mod_bnz(&multiplier, &multiplier, &n);
         bnz_print(&multiplier, 16, "MULTIPLIER (MOD SECP256K1 MODULUS): ");
     } else {
         bnz_print(&multiplier, 16, "MULTIPLIER: ");
@@ -3534,14 +6597,19 @@ void menu_4_4_secp256k1_scalar_multiplication(const char *version)
 
     printf("\n");
 
-    secp256k1_scalar_multiplication(secp256k1, &p, &multiplier);
+    u256_set_bnz(&m, &multiplier);
+    secp256k1_scalar_multiplication(secp256k1, &p, &m);
 
     printf("SECP256K1 POINT:\n");
-    bnz_print(&p.x, 16, " x: ");
-    bnz_print(&p.y, 16, " y: ");
+    u256_print(&p.x, 16, " x: ");
+    u256_print(&p.y, 16, " y: ");
     printf("\n");
 
     printf("press any key to continue...");
+
+    bnz_free(&multiplier);
+    bnz_free(&n);
+
     getchar();
 }
 
@@ -3552,6 +6620,12 @@ int main()
     static char *version = "bitcoin_math\nv0.06, 2025-04-13";
     int menu, running = 1;
     srand(time(NULL));
+    sha256_set_backend(SHA256_BACKEND_AUTO);
+    sha512_set_backend(SHA512_BACKEND_AUTO);
+    if (!secp256k1_self_check(secp256k1_init())) {
+        printf("secp256k1 self check failed\n");
+        return 1;
+    }
     while (running) {
         system("cls");
         printf("%s\n\n", version);